@@ -0,0 +1,114 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstlatencymeta.h"
+
+GType
+gst_latency_meta_api_get_type (void)
+{
+  static gsize type = 0;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstLatencyMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return (GType) type;
+}
+
+static gboolean
+gst_latency_meta_init (GstMeta * meta, gpointer params, GstBuffer * buffer)
+{
+  GstLatencyMeta *lmeta = (GstLatencyMeta *) meta;
+
+  lmeta->id = 0;
+  lmeta->timestamp = GST_CLOCK_TIME_NONE;
+  lmeta->seqnum = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_latency_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstLatencyMeta *lmeta = (GstLatencyMeta *) meta;
+
+  /* the stamp stays valid for any copy of the buffer, and for partial
+   * copies as they still carry data that was stamped at that time */
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    gst_buffer_add_latency_meta (dest, lmeta->id, lmeta->timestamp,
+        lmeta->seqnum);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+const GstMetaInfo *
+gst_latency_meta_get_info (void)
+{
+  static const GstMetaInfo *meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & meta_info)) {
+    const GstMetaInfo *mi = gst_meta_register (GST_LATENCY_META_API_TYPE,
+        "GstLatencyMeta", sizeof (GstLatencyMeta),
+        gst_latency_meta_init, NULL, gst_latency_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & meta_info, (GstMetaInfo *) mi);
+  }
+  return meta_info;
+}
+
+GstLatencyMeta *
+gst_buffer_add_latency_meta (GstBuffer * buffer, GQuark id,
+    GstClockTime timestamp, guint64 seqnum)
+{
+  GstLatencyMeta *meta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+
+  meta = (GstLatencyMeta *) gst_buffer_add_meta (buffer,
+      GST_LATENCY_META_INFO, NULL);
+  meta->id = id;
+  meta->timestamp = timestamp;
+  meta->seqnum = seqnum;
+
+  return meta;
+}
+
+/* returns the meta of the latencystamp named by id, or the first one found
+ * if id is 0 */
+GstLatencyMeta *
+gst_buffer_get_latency_meta (GstBuffer * buffer, GQuark id)
+{
+  gpointer state = NULL;
+  GstMeta *meta;
+
+  while ((meta = gst_buffer_iterate_meta (buffer, &state))) {
+    if (meta->info->api == GST_LATENCY_META_API_TYPE) {
+      GstLatencyMeta *lmeta = (GstLatencyMeta *) meta;
+
+      if (id == 0 || lmeta->id == id)
+        return lmeta;
+    }
+  }
+
+  return NULL;
+}
@@ -0,0 +1,58 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_LATENCY_META_H__
+#define __GST_LATENCY_META_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_LATENCY_META_API_TYPE (gst_latency_meta_api_get_type())
+#define GST_LATENCY_META_INFO (gst_latency_meta_get_info())
+
+typedef struct _GstLatencyMeta GstLatencyMeta;
+
+/**
+ * GstLatencyMeta:
+ * @meta: parent #GstMeta
+ * @id: identifies the latencystamp that attached the meta, 0 if unnamed
+ * @timestamp: monotonic time (gst_util_get_timestamp()) of the stamp
+ * @seqnum: running number of the stamped buffer
+ *
+ * Attached by latencystamp and read by latencyprobe. The meta has no tags,
+ * so it is carried across elements that do not touch it, including video
+ * and audio encoders.
+ */
+struct _GstLatencyMeta {
+  GstMeta        meta;
+
+  GQuark         id;
+  GstClockTime   timestamp;
+  guint64        seqnum;
+};
+
+G_GNUC_INTERNAL GType gst_latency_meta_api_get_type (void);
+G_GNUC_INTERNAL const GstMetaInfo * gst_latency_meta_get_info (void);
+
+G_GNUC_INTERNAL GstLatencyMeta * gst_buffer_add_latency_meta (
+    GstBuffer * buffer, GQuark id, GstClockTime timestamp, guint64 seqnum);
+G_GNUC_INTERNAL GstLatencyMeta * gst_buffer_get_latency_meta (
+    GstBuffer * buffer, GQuark id);
+
+G_END_DECLS
+
+#endif /* __GST_LATENCY_META_H__ */
@@ -0,0 +1,463 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/**
+ * SECTION:element-latencyprobe
+ *
+ * Passes data through unmodified and measures for every buffer the time
+ * since an upstream latencystamp attached its #GstLatencyMeta. Every
+ * #GstLatencyProbe:interval milliseconds the minimum, mean, maximum and
+ * percentiles of these transit times are made available as a #GstStructure
+ * named "latency", through the #GstLatencyProbe:stats property and as an
+ * element message on the bus. Gaps in the stamp sequence numbers are
+ * counted as lost buffers once 64 newer stamps have arrived without them,
+ * so buffers that were only reordered on the way are not counted.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstlatencyprobe.h"
+#include "gstlatencymeta.h"
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+GST_DEBUG_CATEGORY_STATIC (gst_latency_probe_debug);
+#define GST_CAT_DEFAULT gst_latency_probe_debug
+
+#define DEFAULT_ID                      NULL
+#define DEFAULT_STDERR                  FALSE
+#define DEFAULT_SILENT                  TRUE
+#define DEFAULT_POST_MESSAGES           TRUE
+#define DEFAULT_INTERVAL                1000
+
+enum
+{
+  PROP_0,
+  PROP_ID,
+  PROP_LAST_MESSAGE,
+  PROP_STDERR,
+  PROP_SILENT,
+  PROP_POST_MESSAGES,
+  PROP_INTERVAL,
+  PROP_STATS
+};
+
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_latency_probe_debug, "latencyprobe", 0, "latencyprobe element");
+#define gst_latency_probe_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstLatencyProbe, gst_latency_probe,
+    GST_TYPE_BASE_TRANSFORM, _do_init);
+
+static void gst_latency_probe_finalize (GObject * object);
+static void gst_latency_probe_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_latency_probe_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static GstFlowReturn gst_latency_probe_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
+static gboolean gst_latency_probe_start (GstBaseTransform * trans);
+static gboolean gst_latency_probe_stop (GstBaseTransform * trans);
+static void gst_latency_probe_report (GstObject * object, GstClockTime now);
+
+static GParamSpec *pspec_last_message = NULL;
+
+static void
+gst_latency_probe_finalize (GObject * object)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  g_free (probe->id_name);
+  g_free (probe->last_message);
+  if (probe->stats)
+    gst_structure_free (probe->stats);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_latency_probe_class_init (GstLatencyProbeClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseTransformClass *gstbasetrans_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gstelement_class = GST_ELEMENT_CLASS (klass);
+  gstbasetrans_class = GST_BASE_TRANSFORM_CLASS (klass);
+
+  gobject_class->set_property = gst_latency_probe_set_property;
+  gobject_class->get_property = gst_latency_probe_get_property;
+  gobject_class->finalize = gst_latency_probe_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_ID,
+      g_param_spec_string ("id", "Id",
+          "Only measure stamps of the latencystamp with this id, any if unset",
+          DEFAULT_ID, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  pspec_last_message = g_param_spec_string ("last-message", "last-message",
+      "last-message", NULL, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (gobject_class, PROP_LAST_MESSAGE,
+      pspec_last_message);
+  g_object_class_install_property (gobject_class, PROP_STDERR,
+      g_param_spec_boolean ("stderr", "stderr",
+          "Also print measurements to stderr", DEFAULT_STDERR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SILENT,
+      g_param_spec_boolean ("silent", "silent",
+          "Don't format measurements into last-message (implied false by stderr)",
+          DEFAULT_SILENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post Messages",
+          "Post an element message with the stats of every interval",
+          DEFAULT_POST_MESSAGES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_INTERVAL,
+      g_param_spec_uint ("interval", "Report-Interval",
+          "Interval in Milliseconds between two measurements", 1, G_MAXUINT, DEFAULT_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Measurements of the last completed interval", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "Latency Probe",
+      "Generic",
+      "Measure the time since buffers passed a latencystamp",
+      "Peter Körner <peter@mazdermind.de>");
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+
+  gstbasetrans_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gst_latency_probe_transform_ip);
+  gstbasetrans_class->start = GST_DEBUG_FUNCPTR (gst_latency_probe_start);
+  gstbasetrans_class->stop = GST_DEBUG_FUNCPTR (gst_latency_probe_stop);
+}
+
+static void
+gst_latency_probe_init (GstLatencyProbe * probe)
+{
+  probe->id_name = g_strdup (DEFAULT_ID);
+  probe->id = 0;
+  probe->stderr = DEFAULT_STDERR;
+  probe->silent = DEFAULT_SILENT;
+  probe->post_messages = DEFAULT_POST_MESSAGES;
+  probe->last_message = NULL;
+  probe->stats = NULL;
+
+  gst_timing_reporter_init (&probe->reporter, gst_latency_probe_report,
+      DEFAULT_INTERVAL);
+
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM_CAST (probe), TRUE);
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM_CAST (probe), TRUE);
+}
+
+/* A sequence number that was skipped between stamp and probe is only
+ * missing until it arrives late; it counts as lost once it falls out of the
+ * window of the 64 seqnums below the highest one. highest_seqnum starts out
+ * as G_MAXUINT64 so the first stamp seen only synchronizes. */
+static void
+gst_latency_probe_track_seqnum (GstLatencyProbe * probe, guint64 seqnum)
+{
+  guint64 highest = probe->highest_seqnum;
+  guint64 missing = probe->missing_seqnums;
+  guint64 gap, lost = 0;
+
+  if (highest == G_MAXUINT64) {
+    probe->highest_seqnum = seqnum;
+    return;
+  }
+
+  if (seqnum <= highest) {
+    /* a late arrival fills its gap, duplicates change nothing */
+    if (seqnum < highest && highest - 1 - seqnum < 64)
+      probe->missing_seqnums &= ~(G_GUINT64_CONSTANT (1) <<
+          (highest - 1 - seqnum));
+    return;
+  }
+
+  /* seqnums highest + 1 .. seqnum - 1 are now missing, at the bottom of the
+   * window, and everything in it moves up by gap */
+  gap = seqnum - highest;
+  if (gap >= 64) {
+    lost = __builtin_popcountll (missing);
+    if (gap - 1 >= 64) {
+      lost += gap - 1 - 64;
+      missing = G_MAXUINT64;
+    } else {
+      missing = (G_GUINT64_CONSTANT (1) << (gap - 1)) - 1;
+    }
+  } else {
+    lost = __builtin_popcountll (missing >> (64 - gap));
+    missing = (missing << gap) | ((G_GUINT64_CONSTANT (1) << (gap - 1)) - 1);
+  }
+
+  if (lost)
+    GST_TIMING_COUNTER_ADD (probe->count_lost, lost);
+  probe->highest_seqnum = seqnum;
+  probe->missing_seqnums = missing;
+}
+
+static GstFlowReturn
+gst_latency_probe_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (trans);
+  GstLatencyMeta *meta;
+  GstClockTime now;
+
+  meta = gst_buffer_get_latency_meta (buf, probe->id);
+  if (G_UNLIKELY (meta == NULL)) {
+    GST_TIMING_COUNTER_ADD (probe->count_unstamped, 1);
+    return GST_FLOW_OK;
+  }
+
+  now = gst_util_get_timestamp ();
+  gst_timing_histogram_record (&probe->latency,
+      now > meta->timestamp ? now - meta->timestamp : 0);
+
+  gst_latency_probe_track_seqnum (probe, meta->seqnum);
+
+  return GST_FLOW_OK;
+}
+
+/* called with the object lock held, returns the stats of the interval that
+ * just ended or NULL on the very first tick */
+static GstStructure *
+gst_latency_probe_report_unlocked (GstLatencyProbe * probe, GstClockTime now)
+{
+  GstStructure *stats;
+  guint64 unstamped, lost;
+
+  gst_timing_histogram_view_collect (&probe->latency_view, &probe->latency);
+  unstamped = GST_TIMING_COUNTER_GET (probe->count_unstamped);
+  lost = GST_TIMING_COUNTER_GET (probe->count_lost);
+
+  if (!GST_CLOCK_TIME_IS_VALID (probe->last_report)) {
+    probe->last_report = now;
+    probe->last_unstamped = unstamped;
+    probe->last_lost = lost;
+    gst_timing_histogram_view_reset_total (&probe->latency_view);
+    return NULL;
+  }
+
+  stats = gst_structure_new ("latency",
+      "timestamp", G_TYPE_UINT64, now,
+      "interval", G_TYPE_UINT64, now - probe->last_report,
+      "unstamped", G_TYPE_UINT64, unstamped,
+      "lost", G_TYPE_UINT64, lost,
+      "interval-unstamped", G_TYPE_UINT64, unstamped - probe->last_unstamped,
+      "interval-lost", G_TYPE_UINT64, lost - probe->last_lost, NULL);
+  gst_timing_histogram_add_to_structure (&probe->latency_view.interval, stats,
+      "latency");
+  gst_timing_histogram_add_to_structure (&probe->latency_view.total, stats,
+      "total-latency");
+
+  probe->last_report = now;
+  probe->last_unstamped = unstamped;
+  probe->last_lost = lost;
+
+  return stats;
+}
+
+static gchar *
+gst_latency_probe_format_message (const GstStructure * stats)
+{
+  guint64 count, min, p50, p99, max, lost;
+  gdouble mean;
+
+  gst_structure_get_uint64 (stats, "latency-count", &count);
+  gst_structure_get_uint64 (stats, "latency-min", &min);
+  gst_structure_get_double (stats, "latency-mean", &mean);
+  gst_structure_get_uint64 (stats, "latency-p50", &p50);
+  gst_structure_get_uint64 (stats, "latency-p99", &p99);
+  gst_structure_get_uint64 (stats, "latency-max", &max);
+  gst_structure_get_uint64 (stats, "interval-lost", &lost);
+
+  return g_strdup_printf (
+    "Latency of %" G_GUINT64_FORMAT " Buffers: min %.3f ms, mean %.3f ms, median %.3f ms, 99%% %.3f ms, max %.3f ms, %" G_GUINT64_FORMAT " lost",
+    count,
+    (gdouble) min / GST_MSECOND,
+    mean / GST_MSECOND,
+    (gdouble) p50 / GST_MSECOND,
+    (gdouble) p99 / GST_MSECOND,
+    (gdouble) max / GST_MSECOND,
+    lost
+  );
+}
+
+static void
+gst_latency_probe_report (GstObject * object, GstClockTime now)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+  GstStructure *stats;
+  GstMessage *message = NULL;
+  gboolean new_message = FALSE;
+
+  GST_OBJECT_LOCK (probe);
+  stats = gst_latency_probe_report_unlocked (probe, now);
+  if (stats) {
+    if (probe->post_messages)
+      message = gst_message_new_element (GST_OBJECT_CAST (probe),
+          gst_structure_copy (stats));
+
+    if (!probe->silent || probe->stderr) {
+      g_free (probe->last_message);
+      probe->last_message = gst_latency_probe_format_message (stats);
+      new_message = TRUE;
+    }
+
+    if (probe->stats)
+      gst_structure_free (probe->stats);
+    probe->stats = stats;
+  }
+  GST_OBJECT_UNLOCK (probe);
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT_CAST (probe), message);
+
+  if (new_message) {
+    g_object_notify_by_pspec ((GObject *) probe, pspec_last_message);
+    if(probe->stderr)
+      g_message("(%s) %s", GST_ELEMENT_NAME(probe), probe->last_message);
+  }
+}
+
+static gboolean
+gst_latency_probe_start (GstBaseTransform * trans)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (trans);
+  GstClock *clock;
+
+  GST_OBJECT_LOCK (probe);
+  gst_timing_histogram_reset (&probe->latency);
+  gst_timing_histogram_view_init (&probe->latency_view);
+  probe->count_unstamped = 0;
+  probe->count_lost = 0;
+  probe->highest_seqnum = G_MAXUINT64;
+  probe->missing_seqnums = 0;
+  probe->last_report = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (probe);
+
+  clock = gst_system_clock_obtain ();
+  gst_timing_reporter_start (&probe->reporter, GST_OBJECT_CAST (probe), clock);
+  gst_object_unref (clock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_latency_probe_stop (GstBaseTransform * trans)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (trans);
+
+  gst_timing_reporter_stop (&probe->reporter, GST_OBJECT_CAST (probe));
+
+  GST_OBJECT_LOCK (probe);
+  g_free (probe->last_message);
+  probe->last_message = NULL;
+  if (probe->stats)
+    gst_structure_free (probe->stats);
+  probe->stats = NULL;
+  GST_OBJECT_UNLOCK (probe);
+
+  return TRUE;
+}
+
+static void
+gst_latency_probe_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  switch (prop_id) {
+    case PROP_ID:
+      GST_OBJECT_LOCK (probe);
+      g_free (probe->id_name);
+      probe->id_name = g_value_dup_string (value);
+      probe->id = g_quark_from_string (probe->id_name);
+      GST_OBJECT_UNLOCK (probe);
+      break;
+    case PROP_STDERR:
+      probe->stderr = g_value_get_boolean (value);
+      break;
+    case PROP_SILENT:
+      probe->silent = g_value_get_boolean (value);
+      break;
+    case PROP_POST_MESSAGES:
+      probe->post_messages = g_value_get_boolean (value);
+      break;
+    case PROP_INTERVAL:
+      GST_OBJECT_LOCK (probe);
+      probe->reporter.interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (probe);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_latency_probe_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  switch (prop_id) {
+    case PROP_ID:
+      GST_OBJECT_LOCK (probe);
+      g_value_set_string (value, probe->id_name);
+      GST_OBJECT_UNLOCK (probe);
+      break;
+    case PROP_LAST_MESSAGE:
+      GST_OBJECT_LOCK (probe);
+      g_value_set_string (value, probe->last_message);
+      GST_OBJECT_UNLOCK (probe);
+      break;
+    case PROP_STDERR:
+      g_value_set_boolean (value, probe->stderr);
+      break;
+    case PROP_SILENT:
+      g_value_set_boolean (value, probe->silent);
+      break;
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, probe->post_messages);
+      break;
+    case PROP_INTERVAL:
+      GST_OBJECT_LOCK (probe);
+      g_value_set_uint (value, probe->reporter.interval);
+      GST_OBJECT_UNLOCK (probe);
+      break;
+    case PROP_STATS:
+      GST_OBJECT_LOCK (probe);
+      g_value_set_boxed (value, probe->stats);
+      GST_OBJECT_UNLOCK (probe);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
@@ -0,0 +1,88 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+
+#ifndef __GST_LATENCY_PROBE_H__
+#define __GST_LATENCY_PROBE_H__
+
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "gsttiminghistogram.h"
+#include "gsttimingreporter.h"
+
+G_BEGIN_DECLS
+
+
+#define GST_TYPE_LATENCY_PROBE \
+  (gst_latency_probe_get_type())
+#define GST_LATENCY_PROBE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_LATENCY_PROBE,GstLatencyProbe))
+#define GST_LATENCY_PROBE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_LATENCY_PROBE,GstLatencyProbeClass))
+#define GST_IS_LATENCY_PROBE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_LATENCY_PROBE))
+#define GST_IS_LATENCY_PROBE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_LATENCY_PROBE))
+
+typedef struct _GstLatencyProbe GstLatencyProbe;
+typedef struct _GstLatencyProbeClass GstLatencyProbeClass;
+
+/**
+ * GstLatencyProbe:
+ *
+ * Opaque #GstLatencyProbe data structure
+ */
+struct _GstLatencyProbe {
+  GstBaseTransform   element;
+
+  /*< private >*/
+  gchar          *id_name;
+  GQuark         id;
+  gboolean       stderr;
+  gboolean       silent;
+  gboolean       post_messages;
+  gchar          *last_message;
+  GstStructure   *stats;
+
+  GstTimingReporter reporter;
+  GstClockTime   last_report;
+
+  /* written by the streaming thread only */
+  GstTimingHistogram latency;
+  guint64        count_unstamped;
+  guint64        count_lost;
+  /* highest seqnum seen, bit i of missing_seqnums is set while the one i + 1
+   * below it has not arrived */
+  guint64        highest_seqnum;
+  guint64        missing_seqnums;
+
+  /* reporter side, protected by the object lock */
+  GstTimingHistogramView latency_view;
+  guint64        last_unstamped;
+  guint64        last_lost;
+};
+
+struct _GstLatencyProbeClass {
+  GstBaseTransformClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_latency_probe_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_LATENCY_PROBE_H__ */
@@ -0,0 +1,186 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/**
+ * SECTION:element-latencystamp
+ *
+ * Attaches a #GstLatencyMeta with the current monotonic time and a running
+ * sequence number to every buffer. A latencyprobe further downstream reads
+ * it back to measure how long the buffer took to get there.
+ *
+ * |[
+ * gst-launch-1.0 videotestsrc ! latencystamp ! x264enc ! latencyprobe stderr=true ! fakesink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstlatencystamp.h"
+#include "gstlatencymeta.h"
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+GST_DEBUG_CATEGORY_STATIC (gst_latency_stamp_debug);
+#define GST_CAT_DEFAULT gst_latency_stamp_debug
+
+#define DEFAULT_ID                      NULL
+
+enum
+{
+  PROP_0,
+  PROP_ID
+};
+
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_latency_stamp_debug, "latencystamp", 0, "latencystamp element");
+#define gst_latency_stamp_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstLatencyStamp, gst_latency_stamp,
+    GST_TYPE_BASE_TRANSFORM, _do_init);
+
+static void gst_latency_stamp_finalize (GObject * object);
+static void gst_latency_stamp_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_latency_stamp_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static GstFlowReturn gst_latency_stamp_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
+static gboolean gst_latency_stamp_start (GstBaseTransform * trans);
+
+static void
+gst_latency_stamp_finalize (GObject * object)
+{
+  GstLatencyStamp *stamp = GST_LATENCY_STAMP (object);
+
+  g_free (stamp->id_name);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_latency_stamp_class_init (GstLatencyStampClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseTransformClass *gstbasetrans_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gstelement_class = GST_ELEMENT_CLASS (klass);
+  gstbasetrans_class = GST_BASE_TRANSFORM_CLASS (klass);
+
+  gobject_class->set_property = gst_latency_stamp_set_property;
+  gobject_class->get_property = gst_latency_stamp_get_property;
+  gobject_class->finalize = gst_latency_stamp_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_ID,
+      g_param_spec_string ("id", "Id",
+          "Name of the stamp, allows several stamp/probe pairs on one path",
+          DEFAULT_ID, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "Latency Stamp",
+      "Generic",
+      "Stamp buffers for a downstream latencyprobe",
+      "Peter Körner <peter@mazdermind.de>");
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+
+  gstbasetrans_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gst_latency_stamp_transform_ip);
+  gstbasetrans_class->start = GST_DEBUG_FUNCPTR (gst_latency_stamp_start);
+}
+
+static void
+gst_latency_stamp_init (GstLatencyStamp * stamp)
+{
+  stamp->id_name = g_strdup (DEFAULT_ID);
+  stamp->id = 0;
+  stamp->seqnum = 0;
+
+  /* not passthrough: adding the meta needs a writable buffer, which
+   * GstBaseTransform provides without copying the memory */
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM_CAST (stamp), TRUE);
+}
+
+static GstFlowReturn
+gst_latency_stamp_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstLatencyStamp *stamp = GST_LATENCY_STAMP (trans);
+
+  gst_buffer_add_latency_meta (buf, stamp->id, gst_util_get_timestamp (),
+      stamp->seqnum++);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_latency_stamp_start (GstBaseTransform * trans)
+{
+  GstLatencyStamp *stamp = GST_LATENCY_STAMP (trans);
+
+  stamp->seqnum = 0;
+
+  return TRUE;
+}
+
+static void
+gst_latency_stamp_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstLatencyStamp *stamp = GST_LATENCY_STAMP (object);
+
+  switch (prop_id) {
+    case PROP_ID:
+      GST_OBJECT_LOCK (stamp);
+      g_free (stamp->id_name);
+      stamp->id_name = g_value_dup_string (value);
+      stamp->id = g_quark_from_string (stamp->id_name);
+      GST_OBJECT_UNLOCK (stamp);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_latency_stamp_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstLatencyStamp *stamp = GST_LATENCY_STAMP (object);
+
+  switch (prop_id) {
+    case PROP_ID:
+      GST_OBJECT_LOCK (stamp);
+      g_value_set_string (value, stamp->id_name);
+      GST_OBJECT_UNLOCK (stamp);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
@@ -0,0 +1,64 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+
+#ifndef __GST_LATENCY_STAMP_H__
+#define __GST_LATENCY_STAMP_H__
+
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+G_BEGIN_DECLS
+
+
+#define GST_TYPE_LATENCY_STAMP \
+  (gst_latency_stamp_get_type())
+#define GST_LATENCY_STAMP(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_LATENCY_STAMP,GstLatencyStamp))
+#define GST_LATENCY_STAMP_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_LATENCY_STAMP,GstLatencyStampClass))
+#define GST_IS_LATENCY_STAMP(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_LATENCY_STAMP))
+#define GST_IS_LATENCY_STAMP_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_LATENCY_STAMP))
+
+typedef struct _GstLatencyStamp GstLatencyStamp;
+typedef struct _GstLatencyStampClass GstLatencyStampClass;
+
+/**
+ * GstLatencyStamp:
+ *
+ * Opaque #GstLatencyStamp data structure
+ */
+struct _GstLatencyStamp {
+  GstBaseTransform   element;
+
+  /*< private >*/
+  gchar          *id_name;
+  GQuark         id;
+  guint64        seqnum;
+};
+
+struct _GstLatencyStampClass {
+  GstBaseTransformClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_latency_stamp_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_LATENCY_STAMP_H__ */
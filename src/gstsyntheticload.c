@@ -0,0 +1,523 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/**
+ * SECTION:element-syntheticload
+ *
+ * Passes buffers through while behaving like a configurable encoder, for
+ * capacity planning and scaling experiments without licensed codecs.
+ *
+ * Every buffer costs #GstSyntheticLoad:cpu-per-buffer plus
+ * #GstSyntheticLoad:cpu-per-byte times its size of CPU time, spent spinning
+ * in the streaming thread. The time is taken from the CPU clock of the
+ * thread where there is one, so the work per buffer stays the same however
+ * many streams share the cores.
+ *
+ * Buffers can then be held back for #GstSyntheticLoad:latency plus a random
+ * share of #GstSyntheticLoad:latency-jitter, and every Nth buffer for an
+ * extra #GstSyntheticLoad:delay or dropped altogether. The holding blocks
+ * the streaming thread like a synchronous encoder would, it is reported in
+ * the latency query and interrupted by flushing. The random generator is
+ * seeded from #GstSyntheticLoad:seed on every start, so runs repeat.
+ *
+ * |[
+ * gst-launch-1.0 videotestsrc ! syntheticload cpu-per-buffer=8000000 latency=40000000 ! throughput stderr=true ! fakesink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <time.h>
+
+#include "gstsyntheticload.h"
+#include "gsttimingcounter.h"
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+GST_DEBUG_CATEGORY_STATIC (gst_synthetic_load_debug);
+#define GST_CAT_DEFAULT gst_synthetic_load_debug
+
+#define DEFAULT_CPU_PER_BUFFER          0
+#define DEFAULT_CPU_PER_BYTE            0.0
+#define DEFAULT_LATENCY                 0
+#define DEFAULT_LATENCY_JITTER          0
+#define DEFAULT_DROP_EVERY              0
+#define DEFAULT_DELAY_EVERY             0
+#define DEFAULT_DELAY                   0
+#define DEFAULT_SEED                    0
+
+enum
+{
+  PROP_0,
+  PROP_CPU_PER_BUFFER,
+  PROP_CPU_PER_BYTE,
+  PROP_LATENCY,
+  PROP_LATENCY_JITTER,
+  PROP_DROP_EVERY,
+  PROP_DELAY_EVERY,
+  PROP_DELAY,
+  PROP_SEED,
+  PROP_DROPPED,
+  PROP_DELAYED
+};
+
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_synthetic_load_debug, "syntheticload", 0, "syntheticload element");
+#define gst_synthetic_load_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstSyntheticLoad, gst_synthetic_load,
+    GST_TYPE_BASE_TRANSFORM, _do_init);
+
+static void gst_synthetic_load_finalize (GObject * object);
+static void gst_synthetic_load_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_synthetic_load_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static GstStateChangeReturn gst_synthetic_load_change_state (GstElement *
+    element, GstStateChange transition);
+
+static GstFlowReturn gst_synthetic_load_transform_ip (GstBaseTransform *
+    trans, GstBuffer * buf);
+static gboolean gst_synthetic_load_sink_event (GstBaseTransform * trans,
+    GstEvent * event);
+static gboolean gst_synthetic_load_query (GstBaseTransform * trans,
+    GstPadDirection direction, GstQuery * query);
+static gboolean gst_synthetic_load_start (GstBaseTransform * trans);
+
+static void
+gst_synthetic_load_finalize (GObject * object)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (object);
+
+  g_rand_free (load->rand);
+  g_mutex_clear (&load->lock);
+  g_cond_clear (&load->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_synthetic_load_class_init (GstSyntheticLoadClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseTransformClass *gstbasetrans_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gstelement_class = GST_ELEMENT_CLASS (klass);
+  gstbasetrans_class = GST_BASE_TRANSFORM_CLASS (klass);
+
+  gobject_class->set_property = gst_synthetic_load_set_property;
+  gobject_class->get_property = gst_synthetic_load_get_property;
+  gobject_class->finalize = gst_synthetic_load_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_CPU_PER_BUFFER,
+      g_param_spec_uint64 ("cpu-per-buffer", "CPU per Buffer",
+          "CPU time in nanoseconds to spend on every buffer",
+          0, G_MAXUINT64, DEFAULT_CPU_PER_BUFFER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CPU_PER_BYTE,
+      g_param_spec_double ("cpu-per-byte", "CPU per Byte",
+          "CPU time in nanoseconds to spend on every byte of a buffer",
+          0.0, G_MAXDOUBLE, DEFAULT_CPU_PER_BYTE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LATENCY,
+      g_param_spec_uint64 ("latency", "Latency",
+          "Time in nanoseconds to hold every buffer back",
+          0, G_MAXUINT64, DEFAULT_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LATENCY_JITTER,
+      g_param_spec_uint64 ("latency-jitter", "Latency Jitter",
+          "Upper bound in nanoseconds of a random time added to the latency",
+          0, G_MAXUINT64, DEFAULT_LATENCY_JITTER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_DROP_EVERY,
+      g_param_spec_uint ("drop-every", "Drop Every",
+          "Drop every Nth buffer (0 = never)",
+          0, G_MAXUINT, DEFAULT_DROP_EVERY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_DELAY_EVERY,
+      g_param_spec_uint ("delay-every", "Delay Every",
+          "Hold every Nth buffer back for an extra delay (0 = never)",
+          0, G_MAXUINT, DEFAULT_DELAY_EVERY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_DELAY,
+      g_param_spec_uint64 ("delay", "Delay",
+          "Time in nanoseconds to additionally hold every delay-every'th buffer",
+          0, G_MAXUINT64, DEFAULT_DELAY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SEED,
+      g_param_spec_uint ("seed", "Seed",
+          "Seed of the random latency, applied on every start",
+          0, G_MAXUINT, DEFAULT_SEED,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_DROPPED,
+      g_param_spec_uint64 ("dropped", "Dropped",
+          "Number of buffers dropped since start",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_DELAYED,
+      g_param_spec_uint64 ("delayed", "Delayed",
+          "Number of buffers held back for the extra delay since start",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "Synthetic Load",
+      "Generic",
+      "Spend CPU time on, delay and drop buffers like an encoder would",
+      "Peter Körner <peter@mazdermind.de>");
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_synthetic_load_change_state);
+
+  gstbasetrans_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gst_synthetic_load_transform_ip);
+  gstbasetrans_class->sink_event =
+      GST_DEBUG_FUNCPTR (gst_synthetic_load_sink_event);
+  gstbasetrans_class->query = GST_DEBUG_FUNCPTR (gst_synthetic_load_query);
+  gstbasetrans_class->start = GST_DEBUG_FUNCPTR (gst_synthetic_load_start);
+}
+
+static void
+gst_synthetic_load_init (GstSyntheticLoad * load)
+{
+  load->cpu_per_buffer = DEFAULT_CPU_PER_BUFFER;
+  load->cpu_per_byte = DEFAULT_CPU_PER_BYTE;
+  load->latency = DEFAULT_LATENCY;
+  load->latency_jitter = DEFAULT_LATENCY_JITTER;
+  load->drop_every = DEFAULT_DROP_EVERY;
+  load->delay_every = DEFAULT_DELAY_EVERY;
+  load->delay = DEFAULT_DELAY;
+  load->seed = DEFAULT_SEED;
+
+  load->rand = g_rand_new_with_seed (DEFAULT_SEED);
+  load->count = 0;
+  load->dropped = 0;
+  load->delayed = 0;
+
+  g_mutex_init (&load->lock);
+  g_cond_init (&load->cond);
+  load->flushing = FALSE;
+
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM_CAST (load), TRUE);
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM_CAST (load), TRUE);
+}
+
+/* CPU time of the calling thread, the monotonic time where the platform
+ * has no per-thread CPU clock */
+static inline GstClockTime
+gst_synthetic_load_cpu_time (void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return GST_TIMESPEC_TO_TIME (ts);
+#endif
+
+  return g_get_monotonic_time () * GST_USECOND;
+}
+
+/* keeps the spinning from being optimized away */
+static volatile guint32 gst_synthetic_load_sink;
+
+/* spins for cpu_time of CPU time, checking the clock every few thousand
+ * cycles so the clock itself is not most of the work */
+static void
+gst_synthetic_load_burn (GstClockTime cpu_time)
+{
+  GstClockTime end = gst_synthetic_load_cpu_time () + cpu_time;
+  guint32 x = 2463534242u;
+  guint i;
+
+  do {
+    for (i = 0; i < 1024; i++) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+    }
+  } while (gst_synthetic_load_cpu_time () < end);
+
+  gst_synthetic_load_sink = x;
+}
+
+/* blocks the streaming thread for duration, returns FALSE if it was
+ * interrupted by flushing */
+static gboolean
+gst_synthetic_load_hold (GstSyntheticLoad * load, GstClockTime duration)
+{
+  gint64 end = g_get_monotonic_time () + duration / GST_USECOND;
+  gboolean flushing;
+
+  g_mutex_lock (&load->lock);
+  while (!load->flushing && g_cond_wait_until (&load->cond, &load->lock, end));
+  flushing = load->flushing;
+  g_mutex_unlock (&load->lock);
+
+  return !flushing;
+}
+
+static void
+gst_synthetic_load_set_flushing (GstSyntheticLoad * load, gboolean flushing)
+{
+  g_mutex_lock (&load->lock);
+  load->flushing = flushing;
+  g_cond_broadcast (&load->cond);
+  g_mutex_unlock (&load->lock);
+}
+
+/* the longest a buffer can be held back, what the latency query reports */
+static GstClockTime
+gst_synthetic_load_max_hold (GstSyntheticLoad * load)
+{
+  GstClockTime hold;
+
+  GST_OBJECT_LOCK (load);
+  hold = load->latency + load->latency_jitter;
+  if (load->delay_every)
+    hold += load->delay;
+  GST_OBJECT_UNLOCK (load);
+
+  return hold;
+}
+
+static GstFlowReturn
+gst_synthetic_load_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (trans);
+  GstClockTime cpu_time, hold, latency, latency_jitter, delay;
+  guint64 cpu_per_buffer;
+  gdouble cpu_per_byte;
+  guint drop_every, delay_every;
+  guint64 n = ++load->count;
+
+  /* the properties can change while playing, and 64 bit values would tear
+   * on 32 bit platforms without the lock */
+  GST_OBJECT_LOCK (load);
+  cpu_per_buffer = load->cpu_per_buffer;
+  cpu_per_byte = load->cpu_per_byte;
+  latency = load->latency;
+  latency_jitter = load->latency_jitter;
+  drop_every = load->drop_every;
+  delay_every = load->delay_every;
+  delay = load->delay;
+  GST_OBJECT_UNLOCK (load);
+
+  /* dropped buffers cost nothing, like frames an encoder skips */
+  if (drop_every && n % drop_every == 0) {
+    GST_TIMING_COUNTER_ADD (load->dropped, 1);
+    GST_LOG_OBJECT (load, "dropping buffer %" G_GUINT64_FORMAT, n);
+    return GST_BASE_TRANSFORM_FLOW_DROPPED;
+  }
+
+  cpu_time = cpu_per_buffer +
+      (GstClockTime) (cpu_per_byte * gst_buffer_get_size (buf));
+  if (cpu_time)
+    gst_synthetic_load_burn (cpu_time);
+
+  hold = latency;
+  if (latency_jitter)
+    hold += (GstClockTime) g_rand_double_range (load->rand, 0,
+        (gdouble) latency_jitter);
+  if (delay_every && n % delay_every == 0) {
+    GST_TIMING_COUNTER_ADD (load->delayed, 1);
+    hold += delay;
+  }
+
+  if (hold && !gst_synthetic_load_hold (load, hold))
+    return GST_FLOW_FLUSHING;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_synthetic_load_sink_event (GstBaseTransform * trans, GstEvent * event)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (trans);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      gst_synthetic_load_set_flushing (load, TRUE);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_synthetic_load_set_flushing (load, FALSE);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (trans, event);
+}
+
+static gboolean
+gst_synthetic_load_query (GstBaseTransform * trans, GstPadDirection direction,
+    GstQuery * query)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (trans);
+  GstClockTime min, max, hold;
+  gboolean live;
+
+  if (!GST_BASE_TRANSFORM_CLASS (parent_class)->query (trans, direction,
+          query))
+    return FALSE;
+
+  if (direction == GST_PAD_SRC && GST_QUERY_TYPE (query) == GST_QUERY_LATENCY) {
+    hold = gst_synthetic_load_max_hold (load);
+    gst_query_parse_latency (query, &live, &min, &max);
+    min += hold;
+    if (GST_CLOCK_TIME_IS_VALID (max))
+      max += hold;
+    gst_query_set_latency (query, live, min, max);
+  }
+
+  return TRUE;
+}
+
+static GstStateChangeReturn
+gst_synthetic_load_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (element);
+
+  /* wake a held buffer before the streaming thread is shut down */
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_synthetic_load_set_flushing (load, TRUE);
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
+static gboolean
+gst_synthetic_load_start (GstBaseTransform * trans)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (trans);
+
+  load->count = 0;
+  GST_TIMING_COUNTER_SET (load->dropped, 0);
+  GST_TIMING_COUNTER_SET (load->delayed, 0);
+  gst_synthetic_load_set_flushing (load, FALSE);
+
+  GST_OBJECT_LOCK (load);
+  g_rand_set_seed (load->rand, load->seed);
+  GST_OBJECT_UNLOCK (load);
+
+  return TRUE;
+}
+
+static void
+gst_synthetic_load_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (object);
+  gboolean latency_changed = FALSE;
+
+  GST_OBJECT_LOCK (load);
+  switch (prop_id) {
+    case PROP_CPU_PER_BUFFER:
+      load->cpu_per_buffer = g_value_get_uint64 (value);
+      break;
+    case PROP_CPU_PER_BYTE:
+      load->cpu_per_byte = g_value_get_double (value);
+      break;
+    case PROP_LATENCY:
+      load->latency = g_value_get_uint64 (value);
+      latency_changed = TRUE;
+      break;
+    case PROP_LATENCY_JITTER:
+      load->latency_jitter = g_value_get_uint64 (value);
+      latency_changed = TRUE;
+      break;
+    case PROP_DROP_EVERY:
+      load->drop_every = g_value_get_uint (value);
+      break;
+    case PROP_DELAY_EVERY:
+      load->delay_every = g_value_get_uint (value);
+      latency_changed = TRUE;
+      break;
+    case PROP_DELAY:
+      load->delay = g_value_get_uint64 (value);
+      latency_changed = TRUE;
+      break;
+    case PROP_SEED:
+      load->seed = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (load);
+
+  /* let the pipeline redistribute the latency */
+  if (latency_changed)
+    gst_element_post_message (GST_ELEMENT_CAST (load),
+        gst_message_new_latency (GST_OBJECT_CAST (load)));
+}
+
+static void
+gst_synthetic_load_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSyntheticLoad *load = GST_SYNTHETIC_LOAD (object);
+
+  GST_OBJECT_LOCK (load);
+  switch (prop_id) {
+    case PROP_CPU_PER_BUFFER:
+      g_value_set_uint64 (value, load->cpu_per_buffer);
+      break;
+    case PROP_CPU_PER_BYTE:
+      g_value_set_double (value, load->cpu_per_byte);
+      break;
+    case PROP_LATENCY:
+      g_value_set_uint64 (value, load->latency);
+      break;
+    case PROP_LATENCY_JITTER:
+      g_value_set_uint64 (value, load->latency_jitter);
+      break;
+    case PROP_DROP_EVERY:
+      g_value_set_uint (value, load->drop_every);
+      break;
+    case PROP_DELAY_EVERY:
+      g_value_set_uint (value, load->delay_every);
+      break;
+    case PROP_DELAY:
+      g_value_set_uint64 (value, load->delay);
+      break;
+    case PROP_SEED:
+      g_value_set_uint (value, load->seed);
+      break;
+    case PROP_DROPPED:
+      g_value_set_uint64 (value, GST_TIMING_COUNTER_GET (load->dropped));
+      break;
+    case PROP_DELAYED:
+      g_value_set_uint64 (value, GST_TIMING_COUNTER_GET (load->delayed));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (load);
+}
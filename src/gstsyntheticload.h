@@ -0,0 +1,81 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+
+#ifndef __GST_SYNTHETIC_LOAD_H__
+#define __GST_SYNTHETIC_LOAD_H__
+
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+G_BEGIN_DECLS
+
+
+#define GST_TYPE_SYNTHETIC_LOAD \
+  (gst_synthetic_load_get_type())
+#define GST_SYNTHETIC_LOAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SYNTHETIC_LOAD,GstSyntheticLoad))
+#define GST_SYNTHETIC_LOAD_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_SYNTHETIC_LOAD,GstSyntheticLoadClass))
+#define GST_IS_SYNTHETIC_LOAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SYNTHETIC_LOAD))
+#define GST_IS_SYNTHETIC_LOAD_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_SYNTHETIC_LOAD))
+
+typedef struct _GstSyntheticLoad GstSyntheticLoad;
+typedef struct _GstSyntheticLoadClass GstSyntheticLoadClass;
+
+/**
+ * GstSyntheticLoad:
+ *
+ * Opaque #GstSyntheticLoad data structure
+ */
+struct _GstSyntheticLoad {
+  GstBaseTransform   element;
+
+  /*< private >*/
+  /* properties, protected by the object lock */
+  guint64        cpu_per_buffer;
+  gdouble        cpu_per_byte;
+  guint64        latency;
+  guint64        latency_jitter;
+  guint          drop_every;
+  guint          delay_every;
+  guint64        delay;
+  guint          seed;
+
+  /* written by the streaming thread only */
+  GRand          *rand;
+  guint64        count;
+  guint64        dropped;
+  guint64        delayed;
+
+  /* holding buffers, interrupted by flushing */
+  GMutex         lock;
+  GCond          cond;
+  gboolean       flushing;
+};
+
+struct _GstSyntheticLoadClass {
+  GstBaseTransformClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_synthetic_load_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_SYNTHETIC_LOAD_H__ */
@@ -19,14 +19,128 @@
  *
  * Dummy element that passes incoming data through unmodified. It has some
  * useful diagnostic functions, such as offset and timestamp checking.
+ *
+ * Every #GstThroughput:interval milliseconds the measurements are made
+ * available as a #GstStructure named "throughput", both through the
+ * #GstThroughput:stats property and as an element message on the bus. A
+ * human readable #GstThroughput:last-message is only formatted when
+ * #GstThroughput:silent is %FALSE or #GstThroughput:stderr is %TRUE.
+ *
+ * All throughput elements in the process that report on the same clock with
+ * the same interval share a single tick, so their intervals end at the same
+ * time and the stages of a pipeline can be compared interval by interval.
+ * When more than one of them in the same pipeline has stats, the first one
+ * to join also posts them together as one element message named
+ * "throughput-report", with a "measurements" array of the individual stats,
+ * each carrying the name of its "element". It never holds the elements of
+ * another pipeline.
+ *
+ * With #GstThroughput:histograms enabled the report also carries the
+ * percentiles of the wall-clock gaps between buffers ("gap-") and of the
+ * buffer sizes ("size-"), for the interval and since the last
+ * #GstThroughput::reset ("total-"). A buffer list counts as one arrival.
+ *
+ * Next to the rates of the interval itself, every report contains the rates
+ * over each of the sliding #GstThroughput:windows ("-<length>ms" suffix),
+ * built from the measurements of past intervals, and an exponentially
+ * weighted moving average ("ewma-" prefix). Windows are only as fine as the
+ * interval.
+ *
+ * When #GstThroughput:shm-dir is set, the totals and the rates of the last
+ * interval are also published into a memory-mapped file in that directory,
+ * named after the process id, a per-process instance number and the path
+ * of the element, with the layout from
+ * gstthroughputshm.h. External tools such as gst-throughput-top can read it
+ * at any time without a syscall and without any cooperation of the process.
+ *
+ * All wall-clock times, the report ticks as well as the buffer arrivals, are
+ * taken from the #GstThroughput:clock-source. Selecting the pipeline clock
+ * makes the measurements reproducible with a #GstTestClock. The monotonic,
+ * monotonic-coarse and tsc sources are read directly, without a #GstClock,
+ * and are the cheapest for the per-buffer arrival times; their report ticks
+ * are still scheduled on the system clock.
+ *
+ * For timestamped streams in a TIME segment each report also carries the
+ * media time that passed in the interval and the resulting
+ * "realtime-factor", e.g. 3.4 for a transcode running at 3.4x realtime.
+ * When upstream answers a duration query, the "position", "duration" and an
+ * "eta" at the current factor are added, assuming a segment rate of 1.0.
+ * The duration is queried by the streaming thread, after every segment and
+ * at most once per report, so a report can show the one of the previous
+ * interval.
+ *
+ * Frames and samples are counted from the buffer offsets. Buffers without
+ * offsets are counted as one frame each for raw video, by their size for raw
+ * audio and by their duration at the nominal rate otherwise. For raw caps
+ * the report also has the uncompressed bitrate they imply
+ * ("expected-bits-per-second") and the "efficiency", the fraction of it
+ * that was measured.
+ *
+ * With #GstThroughput:sync a buffer list waits on the clock once, for its
+ * first buffer. #GstThroughput:sync-every N only waits for every Nth buffer
+ * or list, so the ones in between run ahead of the clock by up to N - 1
+ * buffer durations; the measured rates still average out over an interval
+ * that is long compared to that.
+ *
+ * With #GstThroughput:lateness every buffer's running time is compared with
+ * the pipeline clock without waiting, the same way a sink would: it is late
+ * when the clock already passed base-time + running time + upstream latency.
+ * The report counts the late buffers ("late-buffers", "total-late-buffers")
+ * and has the percentiles of how late they were ("lateness-"). The deadline
+ * is taken from the presentation timestamp, the decoding timestamp is only
+ * used for buffers without one, so reordered streams are not reported late
+ * by their decoding delay.
+ *
+ * With #GstThroughput:qos a QoS event is sent upstream when buffers are
+ * late, at most once per #GstThroughput:interval. Only enable it where
+ * this element decides about lateness, e.g. in front of a sink that does
+ * not sync or send QoS itself, otherwise upstream is throttled twice.
+ *
+ * Every report also accounts for what did not arrive, separately from the
+ * achieved rates, so a lossy stage can be told apart from a slow one: units
+ * skipped by the buffer offsets ("missing-offsets", using the previous
+ * buffer's offset-end), time skipped by the timestamps by more than half a
+ * buffer duration ("missing-time"), buffers flagged DISCONT and GAP events.
+ * The "total-" variants count since the element started.
+ *
+ * For compressed streams #GstThroughput:frame-types splits the buffers into
+ * keyframes, delta frames (#GST_BUFFER_FLAG_DELTA_UNIT) and headers
+ * (#GST_BUFFER_FLAG_HEADER), reports their counts and byte rates and the
+ * distribution of the GOP length in frames ("gop-") and of the time between
+ * keyframes ("keyframe-interval-"). Buffers with any of the
+ * #GstThroughput:ignore-flags are passed on without being measured at all.
+ *
+ * #GstThroughput:backpressure tells a slow upstream from a blocking
+ * downstream. The time from the return of one push to the arrival of the
+ * next buffer is spent waiting for upstream ("starved-time"), the time in
+ * the push itself waiting for downstream ("blocked-time"). Both are also
+ * reported as the fraction of the interval they took ("starved-ratio",
+ * "blocked-ratio"), together with the distribution of the push durations
+ * ("push-duration-").
+ *
+ * #GstThroughput:memory shows where buffers are copied or freshly allocated.
+ * It reports the number of #GstMemory blocks per buffer ("memories-per-
+ * buffer-"), the memories of the interval by allocator type ("allocators",
+ * e.g. SystemMemory, dmabuf or memfd), how many buffers came from a
+ * #GstBufferPool ("pooled-ratio") and how many memories were seen before
+ * ("recycled-ratio"). The latter looks the backing memory up in a small
+ * cache of recently seen ones, so it is an estimate: pools larger than the
+ * cache or allocators that reuse freed addresses skew it.
  */
 
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
 #endif
 
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
 
 #include "gstthroughput.h"
 
@@ -46,13 +160,30 @@ GST_DEBUG_CATEGORY_STATIC (gst_throughput_debug);
 /* Throughput signals and args */
 enum
 {
-  /* FILL ME */
+  SIGNAL_RESET,
   LAST_SIGNAL
 };
 
 #define DEFAULT_SYNC                    FALSE
 #define DEFAULT_STDERR                  FALSE
 #define DEFAULT_INTERVAL                1000
+#define DEFAULT_SILENT                  TRUE
+#define DEFAULT_POST_MESSAGES           TRUE
+#define DEFAULT_HISTOGRAMS              FALSE
+#define DEFAULT_WINDOWS                 "1000,10000,60000"
+#define DEFAULT_EWMA_TIME_CONSTANT      10000
+#define DEFAULT_SHM_DIR                 NULL
+#define DEFAULT_CLOCK_SOURCE            GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM
+#define DEFAULT_SYNC_EVERY              1
+#define DEFAULT_LATENESS                FALSE
+#define DEFAULT_QOS                     FALSE
+#define DEFAULT_FRAME_TYPES             FALSE
+#define DEFAULT_IGNORE_FLAGS            0
+#define DEFAULT_BACKPRESSURE            FALSE
+#define DEFAULT_MEMORY                  FALSE
+
+/* upper bound for the number of intervals kept for the sliding windows */
+#define MAX_HISTORY                     4096
 
 enum
 {
@@ -60,9 +191,73 @@ enum
   PROP_LAST_MESSAGE,
   PROP_SYNC,
   PROP_STDERR,
-  PROP_INTERVAL
+  PROP_INTERVAL,
+  PROP_SILENT,
+  PROP_POST_MESSAGES,
+  PROP_STATS,
+  PROP_HISTOGRAMS,
+  PROP_WINDOWS,
+  PROP_EWMA_TIME_CONSTANT,
+  PROP_SHM_DIR,
+  PROP_CLOCK_SOURCE,
+  PROP_SYNC_EVERY,
+  PROP_LATENESS,
+  PROP_QOS,
+  PROP_FRAME_TYPES,
+  PROP_IGNORE_FLAGS,
+  PROP_BACKPRESSURE,
+  PROP_MEMORY
 };
 
+GType
+gst_throughput_clock_source_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM, "System clock", "system"},
+    {GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE, "Clock of the pipeline",
+        "pipeline"},
+    {GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC, "CLOCK_MONOTONIC", "monotonic"},
+    {GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC_COARSE,
+        "CLOCK_MONOTONIC_COARSE, only as fine as the scheduler tick",
+        "monotonic-coarse"},
+    {GST_THROUGHPUT_CLOCK_SOURCE_TSC,
+        "Time stamp counter calibrated against CLOCK_MONOTONIC", "tsc"},
+    {0, NULL, NULL},
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstThroughputClockSource", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+/* resolves the direct time sources once when @object starts, the streaming
+ * threads only read the result */
+void
+gst_throughput_clock_source_init (GstObject * object,
+    GstThroughputClockSource clock_source, GstTimingTimeSource * time_source)
+{
+  switch (clock_source) {
+    case GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC:
+      gst_timing_time_source_init_monotonic (time_source);
+      break;
+    case GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC_COARSE:
+      if (!gst_timing_time_source_init_monotonic_coarse (time_source))
+        GST_WARNING_OBJECT (object,
+            "CLOCK_MONOTONIC_COARSE not available, using CLOCK_MONOTONIC");
+      break;
+    case GST_THROUGHPUT_CLOCK_SOURCE_TSC:
+      if (!gst_timing_time_source_init_tsc (time_source))
+        GST_WARNING_OBJECT (object, "no invariant TSC, using CLOCK_MONOTONIC");
+      break;
+    default:
+      break;
+  }
+}
+
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_throughput_debug, "throughput", 0, "throughput element");
@@ -84,12 +279,27 @@ static gboolean gst_throughput_start (GstBaseTransform * trans);
 static gboolean gst_throughput_stop (GstBaseTransform * trans);
 static GstStateChangeReturn gst_throughput_change_state (GstElement * element,
     GstStateChange transition);
+static gboolean gst_throughput_set_clock (GstElement * element,
+    GstClock * clock);
 static gboolean gst_throughput_accept_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps);
 static gboolean gst_throughput_query (GstBaseTransform * base,
     GstPadDirection direction, GstQuery * query);
+static GstStructure *gst_throughput_report (GstObject * object,
+    GstClockTime now);
+static void gst_throughput_use_clock (GstThroughput * throughput,
+    GstClock * clock);
+static GstFlowReturn gst_throughput_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buf);
+static GstFlowReturn gst_throughput_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
+
+static void gst_throughput_reset (GstThroughput * throughput);
+static void gst_throughput_set_windows (GstThroughput * throughput,
+    const gchar * windows);
 
 static GParamSpec *pspec_last_message = NULL;
+static guint gst_throughput_signals[LAST_SIGNAL] = { 0 };
 
 static void
 gst_throughput_finalize (GObject * object)
@@ -98,10 +308,15 @@ gst_throughput_finalize (GObject * object)
 
   throughput = GST_THROUGHPUT (object);
 
-  gst_caps_unref(throughput->video_caps);
-  gst_caps_unref(throughput->audio_caps);
   g_free (throughput->last_message);
+  if (throughput->stats)
+    gst_structure_free (throughput->stats);
+  g_free (throughput->history);
+  g_free (throughput->shm_dir);
   g_cond_clear (&throughput->blocked_cond);
+  if (throughput->element_clock)
+    gst_object_unref (throughput->element_clock);
+  g_slist_free_full (throughput->retired_clocks, gst_object_unref);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -136,6 +351,85 @@ gst_throughput_class_init (GstThroughputClass * klass)
       g_param_spec_uint ("interval", "Report-Interval",
           "Interval in Milliseconds between two measurements", 1, G_MAXUINT, DEFAULT_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SILENT,
+      g_param_spec_boolean ("silent", "silent",
+          "Don't format measurements into last-message (implied false by stderr)",
+          DEFAULT_SILENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post Messages",
+          "Post an element message with the stats of every interval",
+          DEFAULT_POST_MESSAGES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Measurements of the last completed interval", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_HISTOGRAMS,
+      g_param_spec_boolean ("histograms", "Histograms",
+          "Report percentiles of the gaps between and the sizes of buffers",
+          DEFAULT_HISTOGRAMS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_WINDOWS,
+      g_param_spec_string ("windows", "Windows",
+          "Comma separated lengths in Milliseconds of the sliding windows to report rates over",
+          DEFAULT_WINDOWS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_EWMA_TIME_CONSTANT,
+      g_param_spec_uint ("ewma-time-constant", "EWMA Time Constant",
+          "Time constant in Milliseconds of the exponentially weighted moving average rates (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_EWMA_TIME_CONSTANT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SHM_DIR,
+      g_param_spec_string ("shm-dir", "Shared Memory Directory",
+          "Directory to publish the stats to as a memory-mapped file, e.g. /dev/shm/gst-throughput (NULL = disabled)",
+          DEFAULT_SHM_DIR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CLOCK_SOURCE,
+      g_param_spec_enum ("clock-source", "Clock Source",
+          "Clock to take the wall-clock times of the measurements from",
+          GST_TYPE_THROUGHPUT_CLOCK_SOURCE, DEFAULT_CLOCK_SOURCE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_SYNC_EVERY,
+      g_param_spec_uint ("sync-every", "Sync Every",
+          "With sync, only wait on the clock for every Nth buffer or buffer list",
+          1, G_MAXUINT, DEFAULT_SYNC_EVERY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LATENESS,
+      g_param_spec_boolean ("lateness", "Lateness",
+          "Compare the running time of buffers with the pipeline clock and report the late ones",
+          DEFAULT_LATENESS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_QOS,
+      g_param_spec_boolean ("qos", "QoS",
+          "Send a QoS event upstream for late buffers, at most once per interval (needs lateness)",
+          DEFAULT_QOS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_FRAME_TYPES,
+      g_param_spec_boolean ("frame-types", "Frame Types",
+          "Report keyframes, delta frames and headers and the GOP structure",
+          DEFAULT_FRAME_TYPES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_IGNORE_FLAGS,
+      g_param_spec_flags ("ignore-flags", "Ignore Flags",
+          "Pass buffers with any of these flags on without measuring them",
+          GST_TYPE_BUFFER_FLAGS, DEFAULT_IGNORE_FLAGS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BACKPRESSURE,
+      g_param_spec_boolean ("backpressure", "Backpressure",
+          "Report the time spent waiting for upstream and for downstream",
+          DEFAULT_BACKPRESSURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MEMORY,
+      g_param_spec_boolean ("memory", "Memory",
+          "Report the memory blocks, allocators and buffer pool reuse",
+          DEFAULT_MEMORY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstThroughput::reset:
+   * @throughput: the #GstThroughput
+   *
+   * Action signal that restarts the cumulative ("total-") histograms.
+   */
+  gst_throughput_signals[SIGNAL_RESET] =
+      g_signal_new ("reset", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstThroughputClass, reset), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_NONE, 0);
+
+  klass->reset = gst_throughput_reset;
 
 
   gobject_class->finalize = gst_throughput_finalize;
@@ -149,6 +443,7 @@ gst_throughput_class_init (GstThroughputClass * klass)
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_throughput_change_state);
+  gstelement_class->set_clock = GST_DEBUG_FUNCPTR (gst_throughput_set_clock);
 
   gstbasetrans_class->sink_event = GST_DEBUG_FUNCPTR (gst_throughput_sink_event);
   gstbasetrans_class->transform_ip =
@@ -166,20 +461,59 @@ gst_throughput_init (GstThroughput * throughput)
   throughput->sync = DEFAULT_SYNC;
   throughput->stderr = DEFAULT_STDERR;
   throughput->interval = DEFAULT_INTERVAL;
+  throughput->group = NULL;
+  throughput->silent = DEFAULT_SILENT;
+  throughput->post_messages = DEFAULT_POST_MESSAGES;
   throughput->last_message = NULL;
-
-  throughput->video_caps = gst_caps_new_empty_simple("video/x-raw");
-  throughput->audio_caps = gst_caps_new_empty_simple("audio/x-raw");
-
-  throughput->measurement.timestamp = GST_CLOCK_TIME_NONE;
-  throughput->measurement.count_offsets = 0;
-  throughput->measurement.count_buffers = 0;
-  throughput->measurement.count_bytes = 0;
-  throughput->last_measurement = throughput->measurement;
+  throughput->stats = NULL;
+
+  throughput->histograms = DEFAULT_HISTOGRAMS;
+  throughput->clock_source = DEFAULT_CLOCK_SOURCE;
+  throughput->sync_every = DEFAULT_SYNC_EVERY;
+  throughput->sync_count = 0;
+  throughput->sync_clock = NULL;
+  throughput->sync_waiting = FALSE;
+  throughput->lateness = DEFAULT_LATENESS;
+  throughput->qos = DEFAULT_QOS;
+  throughput->qos_running_time = GST_CLOCK_TIME_NONE;
+  throughput->frame_types = DEFAULT_FRAME_TYPES;
+  throughput->drop_buffer_flags = DEFAULT_IGNORE_FLAGS;
+  throughput->backpressure = DEFAULT_BACKPRESSURE;
+  throughput->memory = DEFAULT_MEMORY;
+  throughput->measure_clock = NULL;
+  throughput->duration = GST_CLOCK_TIME_NONE;
+  throughput->duration_stale = FALSE;
+  throughput->element_clock = NULL;
+  throughput->retired_clocks = NULL;
+  throughput->started = FALSE;
+
+  gst_throughput_set_windows (throughput, DEFAULT_WINDOWS);
+  throughput->ewma_time_constant = DEFAULT_EWMA_TIME_CONSTANT;
+  throughput->history = NULL;
+  throughput->history_size = 0;
+  throughput->history_len = 0;
+  throughput->history_head = 0;
+  throughput->have_ewma = FALSE;
+
+  throughput->shm_dir = g_strdup (DEFAULT_SHM_DIR);
+  throughput->shm = NULL;
+  throughput->shm_path = NULL;
+
+  gst_throughput_meter_init (&throughput->meter);
 
   g_cond_init (&throughput->blocked_cond);
 
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM_CAST (throughput), TRUE);
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM_CAST (throughput),
+      TRUE);
+
+  /* wrapped to time the push that GstBaseTransform does inside it */
+  throughput->base_chain =
+      GST_PAD_CHAINFUNC (GST_BASE_TRANSFORM_SINK_PAD (throughput));
+  gst_pad_set_chain_function (GST_BASE_TRANSFORM_SINK_PAD (throughput),
+      GST_DEBUG_FUNCPTR (gst_throughput_chain));
+  gst_pad_set_chain_list_function (GST_BASE_TRANSFORM_SINK_PAD (throughput),
+      GST_DEBUG_FUNCPTR (gst_throughput_chain_list));
 }
 
 static void
@@ -199,6 +533,10 @@ gst_throughput_do_sync (GstThroughput * throughput, GstClockTime running_time)
       GST_BASE_TRANSFORM_CAST (throughput)->segment.format == GST_FORMAT_TIME) {
     GstClock *clock;
 
+    /* the buffers in between pass without waiting */
+    if (throughput->sync_count++ % throughput->sync_every != 0)
+      return GST_FLOW_OK;
+
     GST_OBJECT_LOCK (throughput);
 
     while (throughput->blocked)
@@ -208,21 +546,34 @@ gst_throughput_do_sync (GstThroughput * throughput, GstClockTime running_time)
     if ((clock = GST_ELEMENT (throughput)->clock)) {
       GstClockReturn cret;
       GstClockTime timestamp;
+      GstClockID id;
 
       timestamp = running_time + GST_ELEMENT (throughput)->base_time +
           throughput->upstream_latency;
 
-      /* save id if we need to unlock */
-      throughput->clock_id = gst_clock_new_single_shot_id (clock, timestamp);
+      /* reuse the entry of the previous wait as long as the clock stays the
+       * same, instead of allocating one per buffer */
+      if (throughput->clock_id && (throughput->sync_clock != clock ||
+              !gst_clock_single_shot_id_reinit (clock, throughput->clock_id,
+                  timestamp))) {
+        gst_clock_id_unref (throughput->clock_id);
+        throughput->clock_id = NULL;
+      }
+      if (!throughput->clock_id) {
+        throughput->clock_id = gst_clock_new_single_shot_id (clock, timestamp);
+        gst_object_replace ((GstObject **) & throughput->sync_clock,
+            (GstObject *) clock);
+      }
+
+      /* only replaced by this thread, so it can be used unlocked */
+      id = throughput->clock_id;
+      throughput->sync_waiting = TRUE;
       GST_OBJECT_UNLOCK (throughput);
 
-      cret = gst_clock_id_wait (throughput->clock_id, NULL);
+      cret = gst_clock_id_wait (id, NULL);
 
       GST_OBJECT_LOCK (throughput);
-      if (throughput->clock_id) {
-        gst_clock_id_unref (throughput->clock_id);
-        throughput->clock_id = NULL;
-      }
+      throughput->sync_waiting = FALSE;
       if (cret == GST_CLOCK_UNSCHEDULED)
         ret = GST_FLOW_EOS;
     }
@@ -232,6 +583,22 @@ gst_throughput_do_sync (GstThroughput * throughput, GstClockTime running_time)
   return ret;
 }
 
+static void
+gst_throughput_update_stream_info (GstThroughput * throughput, GstCaps * caps)
+{
+  GstThroughputStreamInfo info;
+
+  gst_throughput_stream_info_from_caps (&info, caps);
+
+  GST_DEBUG_OBJECT (throughput, "stream kind %d, %f units/s, %"
+      G_GSIZE_FORMAT " bytes/unit, %f bits/s", info.kind, info.rate,
+      info.bytes_per_unit, info.expected_bitrate);
+
+  GST_OBJECT_LOCK (throughput);
+  throughput->meter.info = info;
+  GST_OBJECT_UNLOCK (throughput);
+}
+
 static gboolean
 gst_throughput_sink_event (GstBaseTransform * trans, GstEvent * event)
 {
@@ -269,6 +636,9 @@ gst_throughput_sink_event (GstBaseTransform * trans, GstEvent * event)
     GstClockTime start, dur;
 
     gst_event_parse_gap (event, &start, &dur);
+    GST_TIMING_COUNTER_ADD (throughput->loss.gap_events, 1);
+    if (GST_CLOCK_TIME_IS_VALID (dur))
+      GST_TIMING_COUNTER_ADD (throughput->loss.gap_time, dur);
     if (GST_CLOCK_TIME_IS_VALID (start)) {
       start = gst_segment_to_running_time (&trans->segment,
           GST_FORMAT_TIME, start);
@@ -281,141 +651,1079 @@ gst_throughput_sink_event (GstBaseTransform * trans, GstEvent * event)
    * to prevent false warnings when checking for perfect streams */
   if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
     throughput->prev_timestamp = throughput->prev_duration = GST_CLOCK_TIME_NONE;
-    throughput->prev_offset = throughput->prev_offset_end = GST_BUFFER_OFFSET_NONE;
+    gst_throughput_meter_discont (&throughput->meter);
+    throughput->prev_arrival = GST_CLOCK_TIME_NONE;
+    throughput->prev_push_end = GST_CLOCK_TIME_NONE;
+    throughput->have_prev = FALSE;
+    throughput->have_keyframe = FALSE;
+    throughput->qos_running_time = GST_CLOCK_TIME_NONE;
+    g_atomic_int_set (&throughput->duration_stale, TRUE);
+  }
+
+  /* Classify the stream once per caps instead of once per buffer */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+    GstCaps *caps;
+
+    gst_event_parse_caps (event, &caps);
+    gst_throughput_update_stream_info (throughput, caps);
   }
 
+  ret = GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (trans, event);
+
   return ret;
 }
 
+/* queries upstream from the streaming thread instead of from the shared
+ * clock thread of the reports, at most once per report and after every
+ * segment, as the duration can change while the stream grows */
 static void
-gst_throughput_update_last_message_for_buffer (GstThroughput * throughput,
-    GstBuffer * buf, gsize size, guint64 offset_delta)
+gst_throughput_update_duration (GstThroughput * throughput)
 {
+  gint64 duration;
+
+  if (G_LIKELY (!g_atomic_int_get (&throughput->duration_stale)) ||
+      !g_atomic_int_compare_and_exchange (&throughput->duration_stale, TRUE,
+          FALSE))
+    return;
+
+  if (!gst_pad_peer_query_duration (GST_BASE_TRANSFORM_SINK_PAD (throughput),
+          GST_FORMAT_TIME, &duration) || duration < 0)
+    duration = GST_CLOCK_TIME_NONE;
+
   GST_OBJECT_LOCK (throughput);
+  throughput->duration = duration;
+  GST_OBJECT_UNLOCK (throughput);
+}
 
-  GstClock *sysclock = gst_system_clock_obtain();
-  GstClockTime timestamp = gst_clock_get_time(sysclock);
-  gst_object_unref(sysclock);
+/* remembers how far the stream got, as running time for the realtime factor
+ * and as stream time for the ETA */
+static inline void
+gst_throughput_track_position (GstThroughput * throughput, GstBuffer * buf)
+{
+  GstSegment *segment = &GST_BASE_TRANSFORM_CAST (throughput)->segment;
+  GstClockTime ts, position;
+
+  ts = GST_BUFFER_PTS (buf);
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    ts = GST_BUFFER_DTS (buf);
+  if (segment->format != GST_FORMAT_TIME || !GST_CLOCK_TIME_IS_VALID (ts))
+    return;
+
+  if (GST_BUFFER_DURATION_IS_VALID (buf))
+    ts += GST_BUFFER_DURATION (buf);
+
+  position = gst_segment_to_running_time (segment, GST_FORMAT_TIME, ts);
+  if (GST_CLOCK_TIME_IS_VALID (position))
+    GST_TIMING_COUNTER_SET (throughput->running_position, position);
+  position = gst_segment_to_stream_time (segment, GST_FORMAT_TIME, ts);
+  if (GST_CLOCK_TIME_IS_VALID (position))
+    GST_TIMING_COUNTER_SET (throughput->stream_position, position);
+
+  gst_throughput_update_duration (throughput);
+}
 
-  GstCaps *caps = gst_pad_get_current_caps (GST_BASE_TRANSFORM_SINK_PAD(throughput));
-  GstStructure * struc = gst_caps_get_structure(caps, 0);
-  gboolean is_video = gst_caps_is_always_compatible(caps, throughput->video_caps);
-  gboolean is_audio = gst_caps_is_always_compatible(caps, throughput->audio_caps);
+/* compares the first buffer of a buffer or list with the end of the
+ * previous one; skipped offsets are found by the meter */
+static inline void
+gst_throughput_check_continuity (GstThroughput * throughput, GstBuffer * buf)
+{
+  GstThroughputLoss *loss = &throughput->loss;
+  GstClockTime ts = GST_BUFFER_PTS (buf), expected;
+
+  /* the first buffer after a segment is expected to be DISCONT */
+  if (!throughput->have_prev)
+    return;
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT))
+    GST_TIMING_COUNTER_ADD (loss->discont_buffers, 1);
+
+  if (GST_CLOCK_TIME_IS_VALID (ts) &&
+      GST_CLOCK_TIME_IS_VALID (throughput->prev_timestamp) &&
+      GST_CLOCK_TIME_IS_VALID (throughput->prev_duration)) {
+    expected = throughput->prev_timestamp + throughput->prev_duration;
+    if (ts > expected + throughput->prev_duration / 2)
+      GST_TIMING_COUNTER_ADD (loss->missing_time, ts - expected);
+  }
+}
 
-  float offsets_per_second_from_caps = 0.0;
-  if(is_video)
-  {
-    gint num, denom;
-    if(gst_structure_get_fraction(struc, "framerate", &num, &denom))
-    {
-      if(num > 0 && denom > 0)
-        offsets_per_second_from_caps = num / denom;
+static void
+gst_throughput_count (GstThroughput * throughput, GstBuffer * first,
+    GstBuffer * last, guint n_buffers, gsize size)
+{
+  guint64 missing;
+
+  gst_throughput_check_continuity (throughput, first);
+
+  /* runs on the streaming thread for every buffer or buffer list; the
+   * reporter only ever reads these counters, so no lock is taken here */
+  missing = gst_throughput_meter_count_buffers (&throughput->meter, first,
+      last, n_buffers, size);
+  if (missing)
+    GST_TIMING_COUNTER_ADD (throughput->loss.missing_offsets, missing);
+
+  /* update prev values */
+  throughput->prev_timestamp = GST_BUFFER_TIMESTAMP (last);
+  throughput->prev_duration = GST_BUFFER_DURATION (last);
+  throughput->have_prev = TRUE;
+  throughput->offset += size;
+
+  gst_throughput_track_position (throughput, last);
+}
+
+/* sorts a buffer of a compressed stream into keyframe, delta frame or
+ * header and follows the GOP structure */
+static inline void
+gst_throughput_classify (GstThroughput * throughput, GstBuffer * buf,
+    gsize size)
+{
+  GstThroughputFrames *frames = &throughput->frames;
+  GstClockTime pts = GST_BUFFER_PTS (buf);
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER)) {
+    GST_TIMING_COUNTER_ADD (frames->header_buffers, 1);
+    GST_TIMING_COUNTER_ADD (frames->header_bytes, size);
+    return;
+  }
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    GST_TIMING_COUNTER_ADD (frames->delta_frames, 1);
+    GST_TIMING_COUNTER_ADD (frames->delta_bytes, size);
+    throughput->frames_since_keyframe++;
+    return;
+  }
+
+  GST_TIMING_COUNTER_ADD (frames->keyframes, 1);
+  GST_TIMING_COUNTER_ADD (frames->keyframe_bytes, size);
+
+  /* a GOP is a keyframe and the delta frames up to the next one */
+  if (throughput->have_keyframe) {
+    gst_timing_histogram_record (&throughput->gop_lengths,
+        throughput->frames_since_keyframe + 1);
+    if (GST_CLOCK_TIME_IS_VALID (pts) &&
+        GST_CLOCK_TIME_IS_VALID (throughput->prev_keyframe_pts) &&
+        pts > throughput->prev_keyframe_pts)
+      gst_timing_histogram_record (&throughput->keyframe_intervals,
+          pts - throughput->prev_keyframe_pts);
+  }
+
+  throughput->have_keyframe = TRUE;
+  throughput->frames_since_keyframe = 0;
+  throughput->prev_keyframe_pts = pts;
+}
+
+/* the current time of the clock-source, GST_CLOCK_TIME_NONE while there is
+ * no pipeline clock yet */
+static inline GstClockTime
+gst_throughput_now (GstThroughput * throughput)
+{
+  GstClock *clock;
+
+  switch (throughput->clock_source) {
+    case GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM:
+    case GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE:
+      /* can be replaced at any time by set_clock, but stays alive */
+      clock = g_atomic_pointer_get (&throughput->measure_clock);
+      if (!clock)
+        return GST_CLOCK_TIME_NONE;
+      return gst_clock_get_time (clock);
+    default:
+      return gst_timing_time_source_get (&throughput->time_source);
+  }
+}
+
+/* one wall-clock timestamp per buffer or buffer list, only taken when the
+ * histograms are enabled */
+static inline void
+gst_throughput_record_arrival (GstThroughput * throughput)
+{
+  GstClockTime now = gst_throughput_now (throughput);
+
+  if (!GST_CLOCK_TIME_IS_VALID (now))
+    return;
+
+  if (GST_CLOCK_TIME_IS_VALID (throughput->prev_arrival))
+    gst_timing_histogram_record (&throughput->gaps,
+        now - throughput->prev_arrival);
+  throughput->prev_arrival = now;
+}
+
+/* a buffer or buffer list arrived: what passed since the previous push
+ * returned was spent waiting for upstream */
+static inline void
+gst_throughput_backpressure_enter (GstThroughput * throughput)
+{
+  GstClockTime now = gst_throughput_now (throughput);
+
+  if (GST_CLOCK_TIME_IS_VALID (now) &&
+      GST_CLOCK_TIME_IS_VALID (throughput->prev_push_end) &&
+      now > throughput->prev_push_end)
+    GST_TIMING_COUNTER_ADD (throughput->starved_time,
+        now - throughput->prev_push_end);
+  throughput->push_start = GST_CLOCK_TIME_NONE;
+}
+
+/* the push downstream returned; push_start is only set once the buffer was
+ * measured and synced, so neither counts as waiting for downstream */
+static inline void
+gst_throughput_backpressure_leave (GstThroughput * throughput)
+{
+  GstClockTime now = gst_throughput_now (throughput);
+
+  if (GST_CLOCK_TIME_IS_VALID (now) &&
+      GST_CLOCK_TIME_IS_VALID (throughput->push_start) &&
+      now >= throughput->push_start) {
+    GST_TIMING_COUNTER_ADD (throughput->blocked_time,
+        now - throughput->push_start);
+    gst_timing_histogram_record (&throughput->push_durations,
+        now - throughput->push_start);
+  }
+  throughput->prev_push_end = now;
+}
+
+/* counts a memory under the slot of its allocator type; types are compared
+ * by pointer first as they are usually static strings */
+static inline void
+gst_throughput_count_allocator (GstThroughputMemory * counts,
+    const gchar * type)
+{
+  guint i;
+
+  for (i = 0; i < GST_THROUGHPUT_MAX_ALLOCATORS - 1; i++) {
+    const gchar *slot = counts->allocator_types[i];
+
+    if (!slot) {
+      g_atomic_pointer_set (&counts->allocator_types[i], type);
+      break;
     }
+    if (slot == type || g_str_equal (slot, type))
+      break;
   }
-  else if(is_audio)
-  {
-    int rate;
-    if(gst_structure_get_int(struc, "rate", &rate))
-    {
-      offsets_per_second_from_caps = rate;
+
+  GST_TIMING_COUNTER_ADD (counts->allocator_memories[i], 1);
+}
+
+/* memory blocks, allocators and reuse of the backing memory of a buffer */
+static inline void
+gst_throughput_inspect_memory (GstThroughput * throughput, GstBuffer * buf)
+{
+  GstThroughputMemory *counts = &throughput->memory_counts;
+  GstMemory *mem;
+  guint i, n, slot;
+
+  n = gst_buffer_n_memory (buf);
+  gst_timing_histogram_record (&throughput->memories_per_buffer, n);
+  GST_TIMING_COUNTER_ADD (counts->memories, n);
+  if (buf->pool)
+    GST_TIMING_COUNTER_ADD (counts->pooled_buffers, 1);
+
+  for (i = 0; i < n; i++) {
+    mem = gst_buffer_peek_memory (buf, i);
+    gst_throughput_count_allocator (counts, mem->allocator ?
+        mem->allocator->mem_type : "unknown");
+
+    /* sub-memories share the backing memory of their parent */
+    while (mem->parent)
+      mem = mem->parent;
+
+    slot = (guint) ((GPOINTER_TO_SIZE (mem) >> 4) * 2654435761u) %
+        GST_THROUGHPUT_MEMORY_CACHE;
+    if (throughput->seen_memories[slot] == mem) {
+      GST_TIMING_COUNTER_ADD (counts->recycled_memories, 1);
+    } else {
+      throughput->seen_memories[slot] = mem;
+      GST_TIMING_COUNTER_ADD (counts->fresh_memories, 1);
     }
   }
-  gst_caps_unref(caps);
+}
 
-  //g_message("update throughput->measurement.timestamp = timestamp");
-  throughput->measurement.timestamp = timestamp;
-  throughput->measurement.count_buffers++;
-  throughput->measurement.count_bytes += size;
-  if(is_video || is_audio)
-    throughput->measurement.count_offsets += offset_delta;
+/* the measurement that was taken i ticks ago, 0 being the newest */
+static GstThroughputMeasurement *
+gst_throughput_history_get (GstThroughput * throughput, guint i)
+{
+  guint idx;
 
+  idx = (throughput->history_head + throughput->history_size - 1 - i) %
+      throughput->history_size;
 
-  gboolean new_message = FALSE;
-  if(throughput->last_measurement.timestamp == GST_CLOCK_TIME_NONE)
-  {
-    // first measurement
-    //g_message("initialize throughput->last_measurement.timestamp = timestamp");
-    throughput->last_measurement.timestamp = timestamp;
+  return &throughput->history[idx];
+}
+
+static void
+gst_throughput_history_push (GstThroughput * throughput,
+    const GstThroughputMeasurement * measurement)
+{
+  guint i, max_window = 0, size;
+
+  /* keep enough intervals for the longest window, the ring is only resized
+   * here on the reporter when the windows or the interval changed */
+  for (i = 0; i < throughput->n_windows; i++)
+    max_window = MAX (max_window, throughput->windows[i]);
+  size = max_window / MAX (throughput->interval, 1) + 2;
+  size = MIN (size, MAX_HISTORY);
+
+  if (size != throughput->history_size) {
+    GstThroughputMeasurement *history;
+    guint len = MIN (throughput->history_len, size);
+
+    history = g_new (GstThroughputMeasurement, size);
+    for (i = 0; i < len; i++)
+      history[len - 1 - i] = *gst_throughput_history_get (throughput, i);
+
+    g_free (throughput->history);
+    throughput->history = history;
+    throughput->history_size = size;
+    throughput->history_len = len;
+    throughput->history_head = len % size;
+  }
+
+  throughput->history[throughput->history_head] = *measurement;
+  throughput->history_head = (throughput->history_head + 1) % size;
+  throughput->history_len = MIN (throughput->history_len + 1, size);
+}
+
+/* adds the rates over each sliding window, measured from the kept
+ * measurement whose age is closest to the window length */
+static void
+gst_throughput_add_windows (GstThroughput * throughput,
+    const GstThroughputMeasurement * measurement, GstStructure * stats)
+{
+  guint w, i;
+
+  for (w = 0; w < throughput->n_windows; w++) {
+    GstClockTime window = throughput->windows[w] * GST_MSECOND;
+    GstThroughputMeasurement *best = NULL, *m;
+    GstClockTimeDiff diff, best_diff = G_MAXINT64;
+    GstClockTime span = 0;
+    gdouble f = 0.0;
+    gchar *name;
+
+    for (i = 0; i < throughput->history_len; i++) {
+      m = gst_throughput_history_get (throughput, i);
+      diff = ABS (GST_CLOCK_DIFF (m->timestamp, measurement->timestamp) -
+          (GstClockTimeDiff) window);
+      if (diff > best_diff)
+        break;
+      best = m;
+      best_diff = diff;
+    }
+
+    if (best && measurement->timestamp > best->timestamp) {
+      span = measurement->timestamp - best->timestamp;
+      f = (gdouble) GST_SECOND / (gdouble) span;
+    } else {
+      best = (GstThroughputMeasurement *) measurement;
+    }
+
+    name = g_strdup_printf ("window-%ums", throughput->windows[w]);
+    gst_structure_set (stats, name, G_TYPE_UINT64, span, NULL);
+    g_free (name);
+    name = g_strdup_printf ("buffers-per-second-%ums", throughput->windows[w]);
+    gst_structure_set (stats, name, G_TYPE_DOUBLE,
+        f * (measurement->count_buffers - best->count_buffers), NULL);
+    g_free (name);
+    name = g_strdup_printf ("bytes-per-second-%ums", throughput->windows[w]);
+    gst_structure_set (stats, name, G_TYPE_DOUBLE,
+        f * (measurement->count_bytes - best->count_bytes), NULL);
+    g_free (name);
+    name = g_strdup_printf ("offsets-per-second-%ums", throughput->windows[w]);
+    gst_structure_set (stats, name, G_TYPE_DOUBLE,
+        f * (measurement->count_offsets - best->count_offsets), NULL);
+    g_free (name);
+  }
+}
+
+/* updates and adds the exponentially weighted moving average of the rates;
+ * the weight of an interval depends on its length, so late ticks do not
+ * skew the average */
+static void
+gst_throughput_add_ewma (GstThroughput * throughput, GstClockTime tdelta,
+    gdouble buffers_per_second, gdouble bytes_per_second,
+    gdouble offsets_per_second, GstStructure * stats)
+{
+  gdouble alpha;
+
+  if (throughput->ewma_time_constant == 0)
+    return;
+
+  if (!throughput->have_ewma) {
+    throughput->ewma_buffers = buffers_per_second;
+    throughput->ewma_bytes = bytes_per_second;
+    throughput->ewma_offsets = offsets_per_second;
+    throughput->have_ewma = TRUE;
+  } else {
+    alpha = 1.0 - exp (-(gdouble) tdelta /
+        ((gdouble) throughput->ewma_time_constant * GST_MSECOND));
+    throughput->ewma_buffers += alpha *
+        (buffers_per_second - throughput->ewma_buffers);
+    throughput->ewma_bytes += alpha *
+        (bytes_per_second - throughput->ewma_bytes);
+    throughput->ewma_offsets += alpha *
+        (offsets_per_second - throughput->ewma_offsets);
+  }
+
+  gst_structure_set (stats,
+      "ewma-buffers-per-second", G_TYPE_DOUBLE, throughput->ewma_buffers,
+      "ewma-bytes-per-second", G_TYPE_DOUBLE, throughput->ewma_bytes,
+      "ewma-offsets-per-second", G_TYPE_DOUBLE, throughput->ewma_offsets,
+      NULL);
+}
+
+/* adds the media time processed per wall-clock second and, with a known
+ * duration, how long the rest of the stream will take at that pace */
+static void
+gst_throughput_add_realtime (GstThroughput * throughput, GstClockTime tdelta,
+    GstClockTime duration, GstStructure * stats)
+{
+  GstClockTime running, position, media_time, eta;
+  gdouble factor;
+
+  running = GST_TIMING_COUNTER_GET (throughput->running_position);
+  position = GST_TIMING_COUNTER_GET (throughput->stream_position);
+
+  /* nothing timestamped yet, or the running time restarted after a flush */
+  if (!GST_CLOCK_TIME_IS_VALID (running) ||
+      !GST_CLOCK_TIME_IS_VALID (throughput->last_running_position) ||
+      running < throughput->last_running_position) {
+    throughput->last_running_position = running;
+    return;
+  }
+
+  media_time = running - throughput->last_running_position;
+  throughput->last_running_position = running;
+  factor = (gdouble) media_time / (gdouble) tdelta;
+
+  gst_structure_set (stats,
+      "media-time", G_TYPE_UINT64, media_time,
+      "realtime-factor", G_TYPE_DOUBLE, factor, NULL);
+
+  if (!GST_CLOCK_TIME_IS_VALID (duration) || !GST_CLOCK_TIME_IS_VALID (position))
+    return;
+
+  gst_structure_set (stats,
+      "position", G_TYPE_UINT64, position,
+      "duration", G_TYPE_UINT64, duration, NULL);
+
+  if (factor > 0.0) {
+    eta = duration > position ?
+        (GstClockTime) ((duration - position) / factor) : 0;
+    gst_structure_set (stats, "eta", G_TYPE_UINT64, eta, NULL);
+  }
+}
+
+/* adds the keyframe, delta frame and header counts and rates of the
+ * interval and the GOP structure */
+static void
+gst_throughput_add_frame_types (GstThroughput * throughput,
+    GstClockTime tdelta, GstStructure * stats)
+{
+  GstThroughputFrames *live = &throughput->frames;
+  GstThroughputFrames *last = &throughput->frames_last;
+  GstThroughputFrames now;
+  gdouble f = (gdouble) GST_SECOND / (gdouble) tdelta;
+
+  now.keyframes = GST_TIMING_COUNTER_GET (live->keyframes);
+  now.keyframe_bytes = GST_TIMING_COUNTER_GET (live->keyframe_bytes);
+  now.delta_frames = GST_TIMING_COUNTER_GET (live->delta_frames);
+  now.delta_bytes = GST_TIMING_COUNTER_GET (live->delta_bytes);
+  now.header_buffers = GST_TIMING_COUNTER_GET (live->header_buffers);
+  now.header_bytes = GST_TIMING_COUNTER_GET (live->header_bytes);
+
+  gst_structure_set (stats,
+      "keyframes", G_TYPE_UINT64, now.keyframes - last->keyframes,
+      "delta-frames", G_TYPE_UINT64, now.delta_frames - last->delta_frames,
+      "header-buffers", G_TYPE_UINT64,
+      now.header_buffers - last->header_buffers,
+      "keyframe-bytes-per-second", G_TYPE_DOUBLE,
+      f * (now.keyframe_bytes - last->keyframe_bytes),
+      "delta-bytes-per-second", G_TYPE_DOUBLE,
+      f * (now.delta_bytes - last->delta_bytes),
+      "header-bytes-per-second", G_TYPE_DOUBLE,
+      f * (now.header_bytes - last->header_bytes), NULL);
+
+  gst_timing_histogram_add_to_structure (&throughput->gop_lengths_view.interval,
+      stats, "gop");
+  gst_timing_histogram_add_to_structure (&throughput->gop_lengths_view.total,
+      stats, "total-gop");
+  gst_timing_histogram_add_to_structure
+      (&throughput->keyframe_intervals_view.interval, stats,
+      "keyframe-interval");
+  gst_timing_histogram_add_to_structure
+      (&throughput->keyframe_intervals_view.total, stats,
+      "total-keyframe-interval");
+
+  *last = now;
+}
+
+/* adds the time spent waiting for upstream and for downstream in the
+ * interval, absolute and as a fraction of it */
+static void
+gst_throughput_add_backpressure (GstThroughput * throughput,
+    GstClockTime tdelta, GstStructure * stats)
+{
+  guint64 blocked, starved;
+
+  blocked = GST_TIMING_COUNTER_GET (throughput->blocked_time);
+  starved = GST_TIMING_COUNTER_GET (throughput->starved_time);
+
+  gst_structure_set (stats,
+      "blocked-time", G_TYPE_UINT64, blocked - throughput->blocked_time_last,
+      "starved-time", G_TYPE_UINT64, starved - throughput->starved_time_last,
+      "blocked-ratio", G_TYPE_DOUBLE,
+      (gdouble) (blocked - throughput->blocked_time_last) / tdelta,
+      "starved-ratio", G_TYPE_DOUBLE,
+      (gdouble) (starved - throughput->starved_time_last) / tdelta, NULL);
+  gst_timing_histogram_add_to_structure
+      (&throughput->push_durations_view.interval, stats, "push-duration");
+  gst_timing_histogram_add_to_structure
+      (&throughput->push_durations_view.total, stats, "total-push-duration");
+
+  throughput->blocked_time_last = blocked;
+  throughput->starved_time_last = starved;
+}
+
+/* adds the memory blocks per buffer, the memories by allocator type and
+ * the share of pooled buffers and recycled memories of the interval */
+static void
+gst_throughput_add_memory (GstThroughput * throughput,
+    guint64 interval_buffers, GstStructure * stats)
+{
+  GstThroughputMemory *live = &throughput->memory_counts;
+  GstThroughputMemory *last = &throughput->memory_last;
+  GstThroughputMemory now;
+  GstStructure *allocators;
+  const gchar *type;
+  guint64 memories, recycled, fresh;
+  guint i;
+
+  now.memories = GST_TIMING_COUNTER_GET (live->memories);
+  now.pooled_buffers = GST_TIMING_COUNTER_GET (live->pooled_buffers);
+  now.recycled_memories = GST_TIMING_COUNTER_GET (live->recycled_memories);
+  now.fresh_memories = GST_TIMING_COUNTER_GET (live->fresh_memories);
+
+  memories = now.memories - last->memories;
+  recycled = now.recycled_memories - last->recycled_memories;
+  fresh = now.fresh_memories - last->fresh_memories;
+
+  allocators = gst_structure_new_empty ("allocators");
+  for (i = 0; i < GST_THROUGHPUT_MAX_ALLOCATORS; i++) {
+    /* the last slot holds all types that did not fit */
+    if (i == GST_THROUGHPUT_MAX_ALLOCATORS - 1)
+      type = "other";
+    else
+      type = g_atomic_pointer_get (&live->allocator_types[i]);
+    now.allocator_memories[i] =
+        GST_TIMING_COUNTER_GET (live->allocator_memories[i]);
+    if (!type || now.allocator_memories[i] == last->allocator_memories[i])
+      continue;
+    gst_structure_set (allocators, type, G_TYPE_UINT64,
+        now.allocator_memories[i] - last->allocator_memories[i], NULL);
   }
 
+  gst_structure_set (stats,
+      "memories", G_TYPE_UINT64, memories,
+      "pooled-buffers", G_TYPE_UINT64,
+      now.pooled_buffers - last->pooled_buffers,
+      "recycled-memories", G_TYPE_UINT64, recycled,
+      "fresh-memories", G_TYPE_UINT64, fresh,
+      "allocators", GST_TYPE_STRUCTURE, allocators, NULL);
+  gst_structure_free (allocators);
+
+  if (interval_buffers > 0)
+    gst_structure_set (stats, "pooled-ratio", G_TYPE_DOUBLE,
+        (gdouble) (now.pooled_buffers - last->pooled_buffers) /
+        interval_buffers, NULL);
+  if (memories > 0)
+    gst_structure_set (stats, "recycled-ratio", G_TYPE_DOUBLE,
+        (gdouble) recycled / memories, NULL);
+
+  gst_timing_histogram_add_to_structure
+      (&throughput->memories_per_buffer_view.interval, stats,
+      "memories-per-buffer");
+  gst_timing_histogram_add_to_structure
+      (&throughput->memories_per_buffer_view.total, stats,
+      "total-memories-per-buffer");
+
+  *last = now;
+}
+
+/* adds what went missing since the last report and since start */
+static void
+gst_throughput_add_loss (GstThroughput * throughput, guint64 interval_offsets,
+    GstStructure * stats)
+{
+  GstThroughputLoss *live = &throughput->loss, *last = &throughput->loss_last;
+  GstThroughputLoss now;
+
+  now.missing_offsets = GST_TIMING_COUNTER_GET (live->missing_offsets);
+  now.missing_time = GST_TIMING_COUNTER_GET (live->missing_time);
+  now.discont_buffers = GST_TIMING_COUNTER_GET (live->discont_buffers);
+  now.gap_events = GST_TIMING_COUNTER_GET (live->gap_events);
+  now.gap_time = GST_TIMING_COUNTER_GET (live->gap_time);
+
+  gst_structure_set (stats,
+      "missing-offsets", G_TYPE_UINT64,
+      now.missing_offsets - last->missing_offsets,
+      "missing-time", G_TYPE_UINT64, now.missing_time - last->missing_time,
+      "discont-buffers", G_TYPE_UINT64,
+      now.discont_buffers - last->discont_buffers,
+      "gap-events", G_TYPE_UINT64, now.gap_events - last->gap_events,
+      "gap-time", G_TYPE_UINT64, now.gap_time - last->gap_time,
+      "total-missing-offsets", G_TYPE_UINT64, now.missing_offsets,
+      "total-missing-time", G_TYPE_UINT64, now.missing_time,
+      "total-discont-buffers", G_TYPE_UINT64, now.discont_buffers,
+      "total-gap-events", G_TYPE_UINT64, now.gap_events,
+      "total-gap-time", G_TYPE_UINT64, now.gap_time, NULL);
+
+  /* share of the units that should have arrived but did not */
+  if (interval_offsets + now.missing_offsets - last->missing_offsets > 0)
+    gst_structure_set (stats, "loss-ratio", G_TYPE_DOUBLE,
+        (gdouble) (now.missing_offsets - last->missing_offsets) /
+        (interval_offsets + now.missing_offsets - last->missing_offsets),
+        NULL);
+
+  *last = now;
+}
+
+/* called from the reporter with the object lock held, returns the stats of
+ * the interval that just ended or NULL if there is nothing to report yet */
+static GstStructure *
+gst_throughput_report_unlocked (GstThroughput * throughput, GstClockTime now,
+    GstClockTime duration)
+{
+  GstThroughputMeasurement measurement;
+  GstThroughputMeasurement *last = &throughput->meter.last;
+  GstStructure *stats;
+  gdouble buffers_per_second, bytes_per_second, offsets_per_second;
+  guint64 tdelta, interval_buffers, interval_offsets;
+
+  gst_throughput_meter_snapshot (&throughput->meter, now, &measurement);
+
+  if (throughput->histograms) {
+    gst_timing_histogram_view_collect (&throughput->gaps_view,
+        &throughput->gaps);
+    gst_timing_histogram_view_collect (&throughput->sizes_view,
+        &throughput->sizes);
+  }
+  if (throughput->lateness)
+    gst_timing_histogram_view_collect (&throughput->lateness_view,
+        &throughput->lateness_histogram);
+  if (throughput->backpressure)
+    gst_timing_histogram_view_collect (&throughput->push_durations_view,
+        &throughput->push_durations);
+  if (throughput->memory)
+    gst_timing_histogram_view_collect (&throughput->memories_per_buffer_view,
+        &throughput->memories_per_buffer);
+  if (throughput->frame_types) {
+    gst_timing_histogram_view_collect (&throughput->gop_lengths_view,
+        &throughput->gop_lengths);
+    gst_timing_histogram_view_collect (&throughput->keyframe_intervals_view,
+        &throughput->keyframe_intervals);
+  }
+
+  stats = gst_throughput_meter_stats (&throughput->meter, &measurement,
+      "throughput");
+  if (!stats) {
+    /* nothing has flowed yet, start the first interval from here */
+    *last = measurement;
+    throughput->last_running_position =
+        GST_TIMING_COUNTER_GET (throughput->running_position);
+    throughput->history_len = 0;
+    throughput->have_ewma = FALSE;
+    gst_throughput_history_push (throughput, &measurement);
+    return NULL;
+  }
+
+  if (throughput->histograms) {
+    gst_timing_histogram_add_to_structure (&throughput->gaps_view.interval,
+        stats, "gap");
+    gst_timing_histogram_add_to_structure (&throughput->gaps_view.total,
+        stats, "total-gap");
+    gst_timing_histogram_add_to_structure (&throughput->sizes_view.interval,
+        stats, "size");
+    gst_timing_histogram_add_to_structure (&throughput->sizes_view.total,
+        stats, "total-size");
+  }
+
+  if (throughput->lateness) {
+    gst_structure_set (stats,
+        "late-buffers", G_TYPE_UINT64, throughput->lateness_view.interval.count,
+        "total-late-buffers", G_TYPE_UINT64,
+        throughput->lateness_view.total.count, NULL);
+    gst_timing_histogram_add_to_structure (&throughput->lateness_view.interval,
+        stats, "lateness");
+    gst_timing_histogram_add_to_structure (&throughput->lateness_view.total,
+        stats, "total-lateness");
+  }
+
+  gst_structure_get (stats,
+      "interval", G_TYPE_UINT64, &tdelta,
+      "interval-buffers", G_TYPE_UINT64, &interval_buffers,
+      "interval-offsets", G_TYPE_UINT64, &interval_offsets,
+      "buffers-per-second", G_TYPE_DOUBLE, &buffers_per_second,
+      "bytes-per-second", G_TYPE_DOUBLE, &bytes_per_second,
+      "offsets-per-second", G_TYPE_DOUBLE, &offsets_per_second, NULL);
+
+  gst_throughput_add_windows (throughput, &measurement, stats);
+  gst_throughput_history_push (throughput, &measurement);
+  gst_throughput_add_ewma (throughput, tdelta, buffers_per_second,
+      bytes_per_second, offsets_per_second, stats);
+  gst_throughput_add_realtime (throughput, tdelta, duration, stats);
+  gst_throughput_add_loss (throughput, interval_offsets, stats);
+  if (throughput->frame_types)
+    gst_throughput_add_frame_types (throughput, tdelta, stats);
+  if (throughput->backpressure)
+    gst_throughput_add_backpressure (throughput, tdelta, stats);
+  if (throughput->memory)
+    gst_throughput_add_memory (throughput, interval_buffers, stats);
+
+  *last = measurement;
+
+  return stats;
+}
+
+static gchar *gst_throughput_format_rates (const GstStructure * stats);
+
+/* turns the stats of an interval into the human readable last-message, only
+ * done when asked for with silent=false or stderr=true */
+static gchar *
+gst_throughput_format_message (const GstStructure * stats)
+{
+  gchar *message, *extended;
+  gdouble factor, blocked, starved, pooled, recycled;
+  guint64 eta;
+
+  message = gst_throughput_format_rates (stats);
+
+  if (gst_structure_get_double (stats, "realtime-factor", &factor)) {
+    if (gst_structure_get_uint64 (stats, "eta", &eta))
+      extended = g_strdup_printf ("%s, %.2fx realtime, ETA %" GST_TIME_FORMAT,
+          message, factor, GST_TIME_ARGS (eta));
+    else
+      extended = g_strdup_printf ("%s, %.2fx realtime", message, factor);
+    g_free (message);
+    message = extended;
+  }
+
+  if (gst_structure_get_double (stats, "blocked-ratio", &blocked) &&
+      gst_structure_get_double (stats, "starved-ratio", &starved)) {
+    extended = g_strdup_printf ("%s, %.0f%% blocked downstream, "
+        "%.0f%% starved upstream", message, blocked * 100, starved * 100);
+    g_free (message);
+    message = extended;
+  }
+
+  if (gst_structure_get_double (stats, "pooled-ratio", &pooled) &&
+      gst_structure_get_double (stats, "recycled-ratio", &recycled)) {
+    extended = g_strdup_printf ("%s, %.0f%% pooled, %.0f%% memory recycled",
+        message, pooled * 100, recycled * 100);
+    g_free (message);
+    message = extended;
+  }
+
+  return message;
+}
+
+static gchar *
+gst_throughput_format_rates (const GstStructure * stats)
+{
+  const gchar *kind;
+  gdouble buffers_per_second, bytes_per_second, offsets_per_second;
+  gdouble offsets_per_second_from_caps;
+  gdouble mbytes_per_second, mbits_per_second;
+
+  kind = gst_structure_get_string (stats, "media-kind");
+  gst_structure_get_double (stats, "buffers-per-second", &buffers_per_second);
+  gst_structure_get_double (stats, "bytes-per-second", &bytes_per_second);
+  gst_structure_get_double (stats, "offsets-per-second", &offsets_per_second);
+  gst_structure_get_double (stats, "nominal-rate",
+      &offsets_per_second_from_caps);
+
+  mbytes_per_second = bytes_per_second / 1024 / 1024;
+  mbits_per_second = mbytes_per_second * 8;
+
+  if(g_str_equal (kind, "video")) {
+    return g_strdup_printf (
+      "Transfering %.0f Buffers/s (%.0f Frames/s) of a %.0f Frames/s stream (=%.1f%%) at %.2f MBit/s (= %.2f MByte/s)",
+      buffers_per_second,
+      offsets_per_second,
+      offsets_per_second_from_caps,
+      offsets_per_second / offsets_per_second_from_caps * 100,
+      mbits_per_second,
+      mbytes_per_second
+    );
+  }
+  else if(g_str_equal (kind, "audio"))
+  {
+    return g_strdup_printf (
+      "Transfering %.0f Buffers/s (%.0f Sample/s) of a %.0f Sample/s stream (=%.1f%%) at %.2f MBit/s (= %.2f MByte/s)",
+      buffers_per_second,
+      offsets_per_second,
+      offsets_per_second_from_caps,
+      offsets_per_second / offsets_per_second_from_caps * 100,
+      mbits_per_second,
+      mbytes_per_second
+    );
+  }
   else
   {
-    GstClockTime tdelta = throughput->measurement.timestamp - throughput->last_measurement.timestamp;
-    //g_message("tdelta = throughput->measurement.timestamp - throughput->last_measurement.timestamp = %" G_GUINT64_FORMAT, tdelta);
+    return g_strdup_printf (
+      "Transfering %.0f Buffers/s at %.2f MBit/s (= %.2f MByte/s)",
+      buffers_per_second,
+      mbits_per_second,
+      mbytes_per_second
+    );
+  }
+}
 
-    if(tdelta > throughput->interval*1000*1000)
-    {
-      float f = 1000000000.0/(float)tdelta;
-      float buffers_per_second = f * (throughput->measurement.count_buffers - throughput->last_measurement.count_buffers);
-      float mbytes_per_second =  f * (throughput->measurement.count_bytes - throughput->last_measurement.count_bytes) / 1024 / 1024;
-      float mbits_per_second =   mbytes_per_second * 8;
-      float offsets_per_second = f * (throughput->measurement.count_offsets - throughput->last_measurement.count_offsets);
+/* creates the stats file in shm-dir; the header is filled in before the
+ * file is renamed into place, so readers never see a partial one. Element
+ * names and even paths repeat across the pipelines of a process, so the
+ * file name also carries a number unique to the process */
+static gboolean
+gst_throughput_shm_open (GstThroughput * throughput)
+{
+  static gint instance = 0;
+  GstThroughputShm *shm = MAP_FAILED;
+  gchar *dir, *name, *basename, *path, *tmp, *object_path;
+  int fd;
 
-      new_message = TRUE;
-      g_free (throughput->last_message);
-      if(is_video) {
-         throughput->last_message = g_strdup_printf (
-          "Transfering %.0f Buffers/s (%.0f Frames/s) of a %.0f Frames/s stream (=%.1f%%) at %.2f MBit/s (= %.2f MByte/s)",
-          buffers_per_second,
-          offsets_per_second,
-          offsets_per_second_from_caps,
-          offsets_per_second / offsets_per_second_from_caps * 100,
-          mbits_per_second,
-          mbytes_per_second
-        );
-      }
-      else if(is_audio)
-      {
-         throughput->last_message = g_strdup_printf (
-          "Transfering %.0f Buffers/s (%.0f Sample/s) of a %.0f Sample/s stream (=%.1f%%) at %.2f MBit/s (= %.2f MByte/s)",
-          buffers_per_second,
-          offsets_per_second,
-          offsets_per_second_from_caps,
-          offsets_per_second / offsets_per_second_from_caps * 100,
-          mbits_per_second,
-          mbytes_per_second
-        );
-      }
-      else
-      {
-         throughput->last_message = g_strdup_printf (
-          "Transfering %.0f Buffers/s at %.2f MBit/s (= %.2f MByte/s)",
-          buffers_per_second,
-          mbits_per_second,
-          mbytes_per_second
-        );
-      }
+  GST_OBJECT_LOCK (throughput);
+  dir = g_strdup (throughput->shm_dir);
+  GST_OBJECT_UNLOCK (throughput);
 
-      throughput->last_measurement = throughput->measurement;
-    }
+  if (!dir || !*dir) {
+    g_free (dir);
+    return TRUE;
   }
 
+  object_path = gst_object_get_path_string (GST_OBJECT_CAST (throughput));
+  name = g_strdelimit (g_strdup (object_path + 1), G_DIR_SEPARATOR_S, '_');
+  g_free (object_path);
+  basename = g_strdup_printf ("%d-%d-%.100s" GST_THROUGHPUT_SHM_SUFFIX,
+      (int) getpid (), g_atomic_int_add (&instance, 1), name);
+  path = g_build_filename (dir, basename, NULL);
+  tmp = g_strconcat (path, ".tmp", NULL);
+  g_free (basename);
+  g_free (name);
+
+  if (g_mkdir_with_parents (dir, 0755) < 0)
+    goto error;
+
+  fd = g_open (tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    goto error;
+  if (ftruncate (fd, sizeof (GstThroughputShm)) == 0)
+    shm = mmap (NULL, sizeof (GstThroughputShm), PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+  close (fd);
+  if (shm == MAP_FAILED)
+    goto error;
+
+  object_path = gst_object_get_path_string (GST_OBJECT_CAST (throughput));
+  shm->magic = GST_THROUGHPUT_SHM_MAGIC;
+  shm->version = GST_THROUGHPUT_SHM_VERSION;
+  shm->size = sizeof (GstThroughputShm);
+  shm->pid = getpid ();
+  g_strlcpy (shm->name, object_path, sizeof (shm->name));
+  g_free (object_path);
+
+  if (g_rename (tmp, path) < 0)
+    goto error;
+
+  GST_DEBUG_OBJECT (throughput, "publishing stats to %s", path);
+
+  GST_OBJECT_LOCK (throughput);
+  throughput->shm = shm;
+  throughput->shm_path = path;
   GST_OBJECT_UNLOCK (throughput);
 
-  if(G_UNLIKELY(new_message))
+  g_free (tmp);
+  g_free (dir);
+
+  return TRUE;
+
+error:
+  GST_ELEMENT_ERROR (throughput, RESOURCE, OPEN_WRITE,
+      ("Could not create stats file \"%s\".", path), GST_ERROR_SYSTEM);
+  if (shm != MAP_FAILED)
+    munmap (shm, sizeof (GstThroughputShm));
+  g_unlink (tmp);
+  g_free (tmp);
+  g_free (path);
+  g_free (dir);
+
+  return FALSE;
+}
+
+static void
+gst_throughput_shm_close (GstThroughput * throughput)
+{
+  GstThroughputShm *shm;
+  gchar *path;
+
+  GST_OBJECT_LOCK (throughput);
+  shm = throughput->shm;
+  path = throughput->shm_path;
+  throughput->shm = NULL;
+  throughput->shm_path = NULL;
+  GST_OBJECT_UNLOCK (throughput);
+
+  if (!shm)
+    return;
+
+  g_unlink (path);
+  munmap (shm, sizeof (GstThroughputShm));
+  g_free (path);
+}
+
+/* called from the reporter with the object lock held */
+static void
+gst_throughput_shm_publish (GstThroughput * throughput,
+    const GstStructure * stats)
+{
+  GstThroughputShm *shm = throughput->shm;
+  guint64 timestamp, interval, buffers, bytes, offsets;
+  gdouble nominal_rate, buffers_per_second, bytes_per_second;
+  gdouble offsets_per_second;
+
+  gst_structure_get (stats,
+      "interval", G_TYPE_UINT64, &interval,
+      "buffers", G_TYPE_UINT64, &buffers,
+      "bytes", G_TYPE_UINT64, &bytes,
+      "offsets", G_TYPE_UINT64, &offsets,
+      "nominal-rate", G_TYPE_DOUBLE, &nominal_rate,
+      "buffers-per-second", G_TYPE_DOUBLE, &buffers_per_second,
+      "bytes-per-second", G_TYPE_DOUBLE, &bytes_per_second,
+      "offsets-per-second", G_TYPE_DOUBLE, &offsets_per_second, NULL);
+
+  /* readers compare it with their own CLOCK_MONOTONIC, whatever the
+   * clock-source */
+  timestamp = g_get_monotonic_time () * GST_USECOND;
+
+  gst_throughput_shm_write_begin (shm);
+  shm->media_kind = throughput->meter.info.kind;
+  shm->timestamp = timestamp;
+  shm->interval = interval;
+  shm->buffers = buffers;
+  shm->bytes = bytes;
+  shm->offsets = offsets;
+  shm->nominal_rate = nominal_rate;
+  shm->buffers_per_second = buffers_per_second;
+  shm->bytes_per_second = bytes_per_second;
+  shm->offsets_per_second = offsets_per_second;
+  gst_throughput_shm_write_end (shm);
+}
+
+/* called on the shared tick of the registry group, returns a copy of the
+ * new stats for the group's combined report */
+static GstStructure *
+gst_throughput_report (GstObject * object, GstClockTime now)
+{
+  GstThroughput *throughput = GST_THROUGHPUT (object);
+  GstStructure *stats, *result = NULL;
+  GstMessage *message = NULL;
+  gboolean new_message = FALSE;
+
+  /* the tick only paces the reports for the direct time sources */
+  if (throughput->clock_source != GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM &&
+      throughput->clock_source != GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE)
+    now = gst_timing_time_source_get (&throughput->time_source);
+
+  GST_OBJECT_LOCK (throughput);
+  stats = gst_throughput_report_unlocked (throughput, now,
+      throughput->duration);
+  g_atomic_int_set (&throughput->duration_stale, TRUE);
+  if (stats) {
+    if (throughput->shm)
+      gst_throughput_shm_publish (throughput, stats);
+
+    if (throughput->post_messages)
+      message = gst_message_new_element (GST_OBJECT_CAST (throughput),
+          gst_structure_copy (stats));
+
+    if (!throughput->silent || throughput->stderr) {
+      g_free (throughput->last_message);
+      throughput->last_message = gst_throughput_format_message (stats);
+      new_message = TRUE;
+    }
+
+    if (throughput->stats)
+      gst_structure_free (throughput->stats);
+    throughput->stats = stats;
+    result = gst_structure_copy (stats);
+  }
+  GST_OBJECT_UNLOCK (throughput);
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT_CAST (throughput), message);
+
+  if (new_message)
     gst_throughput_notify_last_message (throughput);
+
+  return result;
 }
 
-static GstFlowReturn
-gst_throughput_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+/* Compares the deadline of a buffer, when a sink synchronizing on the
+ * pipeline clock would present it, with the clock right now. Never waits. */
+static void
+gst_throughput_check_deadline (GstThroughput * throughput, GstBuffer * buf)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  GstThroughput *throughput = GST_THROUGHPUT (trans);
-  GstClockTime rundts = GST_CLOCK_TIME_NONE;
-  GstClockTime runpts = GST_CLOCK_TIME_NONE;
-  GstClockTime runtimestamp;
-  gsize size;
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (throughput);
+  GstClock *clock;
+  GstClockTime running_time, deadline, now, qos_period;
+  GstClockTimeDiff lateness;
+  GstEvent *event;
 
-  size = gst_buffer_get_size (buf);
-  guint64 offset_delta = GST_BUFFER_OFFSET (buf) - throughput->prev_offset;
+  if (trans->segment.format != GST_FORMAT_TIME)
+    return;
 
-  /* update prev values */
-  throughput->prev_timestamp = GST_BUFFER_TIMESTAMP (buf);
-  throughput->prev_duration = GST_BUFFER_DURATION (buf);
-  throughput->prev_offset_end = GST_BUFFER_OFFSET_END (buf);
-  throughput->prev_offset = GST_BUFFER_OFFSET (buf);
+  /* B-frames are decoded before but presented after their DTS */
+  running_time = gst_segment_to_running_time (&trans->segment,
+      GST_FORMAT_TIME, GST_BUFFER_PTS_IS_VALID (buf) ? GST_BUFFER_PTS (buf) :
+      GST_BUFFER_DTS (buf));
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return;
+
+  if (!(clock = g_atomic_pointer_get (&throughput->element_clock)))
+    return;
+
+  GST_OBJECT_LOCK (throughput);
+  deadline = running_time + GST_ELEMENT_CAST (throughput)->base_time +
+      throughput->upstream_latency;
+  qos_period = throughput->interval * GST_MSECOND;
+  GST_OBJECT_UNLOCK (throughput);
+
+  now = gst_clock_get_time (clock);
+
+  lateness = GST_CLOCK_DIFF (deadline, now);
+  if (lateness <= 0)
+    return;
+
+  gst_timing_histogram_record (&throughput->lateness_histogram, lateness);
 
-  gst_throughput_update_last_message_for_buffer (throughput, buf, size, offset_delta);
+  if (!throughput->qos)
+    return;
+
+  /* one event per interval, a new segment starts over */
+  if (GST_CLOCK_TIME_IS_VALID (throughput->qos_running_time) &&
+      running_time >= throughput->qos_running_time &&
+      running_time < throughput->qos_running_time + qos_period)
+    return;
+  throughput->qos_running_time = running_time;
+
+  GST_LOG_OBJECT (throughput, "buffer at %" GST_TIME_FORMAT " is %"
+      GST_STIME_FORMAT " late", GST_TIME_ARGS (running_time),
+      GST_STIME_ARGS (lateness));
+  event = gst_event_new_qos (GST_QOS_TYPE_OVERFLOW, 1.0, lateness,
+      running_time);
+  gst_pad_push_event (GST_BASE_TRANSFORM_SINK_PAD (throughput), event);
+}
+
+static GstClockTime
+gst_throughput_running_time (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstClockTime rundts = GST_CLOCK_TIME_NONE;
+  GstClockTime runpts = GST_CLOCK_TIME_NONE;
 
   if (trans->segment.format == GST_FORMAT_TIME) {
     rundts = gst_segment_to_running_time (&trans->segment,
@@ -425,14 +1733,205 @@ gst_throughput_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   }
 
   if (GST_CLOCK_TIME_IS_VALID (rundts))
-    runtimestamp = rundts;
+    return rundts;
   else if (GST_CLOCK_TIME_IS_VALID (runpts))
-    runtimestamp = runpts;
+    return runpts;
   else
-    runtimestamp = 0;
-  ret = gst_throughput_do_sync (throughput, runtimestamp);
+    return 0;
+}
 
-  throughput->offset += size;
+static GstFlowReturn
+gst_throughput_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstThroughput *throughput = GST_THROUGHPUT (trans);
+  gsize size = gst_buffer_get_size (buf);
+  GstClockTime running_time;
+  GstFlowReturn ret;
+
+  running_time = gst_throughput_running_time (trans, buf);
+
+  /* ignored buffers are passed on and synced, but not measured */
+  if (!(GST_BUFFER_FLAGS (buf) & throughput->drop_buffer_flags)) {
+    if (throughput->histograms) {
+      gst_throughput_record_arrival (throughput);
+      gst_timing_histogram_record (&throughput->sizes, size);
+    }
+    if (throughput->frame_types)
+      gst_throughput_classify (throughput, buf, size);
+    if (throughput->memory)
+      gst_throughput_inspect_memory (throughput, buf);
+
+    gst_throughput_count (throughput, buf, buf, 1, size);
+
+    if (throughput->lateness)
+      gst_throughput_check_deadline (throughput, buf);
+  }
+
+  ret = gst_throughput_do_sync (throughput, running_time);
+
+  /* GstBaseTransform pushes right after we return */
+  if (throughput->backpressure)
+    throughput->push_start = gst_throughput_now (throughput);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_throughput_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstThroughput *throughput = GST_THROUGHPUT (parent);
+  GstFlowReturn ret;
+
+  if (!throughput->backpressure)
+    return throughput->base_chain (pad, parent, buf);
+
+  gst_throughput_backpressure_enter (throughput);
+  ret = throughput->base_chain (pad, parent, buf);
+  gst_throughput_backpressure_leave (throughput);
+
+  return ret;
+}
+
+/* hands the buffers of the list to the chain function one by one, which is
+ * what the default GstPad chain_list implementation does */
+static GstFlowReturn
+gst_throughput_chain_list_unpacked (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstPadChainFunction chain = GST_PAD_CHAINFUNC (pad);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+    ret = chain (pad, parent, gst_buffer_ref (gst_buffer_list_get (list, i)));
+
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
+/* the segment position GstBaseTransform would have recorded after pushing
+ * the buffers of the list one by one */
+static GstClockTime
+gst_throughput_list_position (GstBaseTransform * trans, GstBufferList * list)
+{
+  GstBuffer *buf;
+  guint i, len = gst_buffer_list_length (list);
+
+  if (trans->segment.format != GST_FORMAT_TIME)
+    return GST_CLOCK_TIME_NONE;
+
+  for (i = len; i > 0; i--) {
+    buf = gst_buffer_list_get (list, i - 1);
+    if (!GST_BUFFER_PTS_IS_VALID (buf))
+      continue;
+    if (trans->segment.rate < 0.0 || !GST_BUFFER_DURATION_IS_VALID (buf))
+      return GST_BUFFER_PTS (buf);
+    return GST_BUFFER_PTS (buf) + GST_BUFFER_DURATION (buf);
+  }
+
+  return GST_CLOCK_TIME_NONE;
+}
+
+static GstFlowReturn
+gst_throughput_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (parent);
+  GstThroughput *throughput = GST_THROUGHPUT (parent);
+  GstBuffer *first, *last;
+  GstClockTime running_time, position;
+  GstFlowReturn ret;
+  gsize size = 0;
+  guint i, len, n_buffers;
+
+  len = gst_buffer_list_length (list);
+  if (len == 0) {
+    gst_buffer_list_unref (list);
+    return GST_FLOW_OK;
+  }
+
+  /* The list can only be forwarded as a whole while we are passthrough, are
+   * negotiated and GstBaseTransform has no caps or allocation renegotiation
+   * pending, which it only performs from its per-buffer chain function. The
+   * buffers of a list also bypass the QoS of GstBaseTransform itself, which
+   * is off by default. */
+  if (!gst_base_transform_is_passthrough (trans) ||
+      !gst_pad_has_current_caps (trans->sinkpad) ||
+      gst_pad_needs_reconfigure (trans->srcpad))
+    return gst_throughput_chain_list_unpacked (pad, parent, list);
+
+  if (throughput->backpressure)
+    gst_throughput_backpressure_enter (throughput);
+
+  first = gst_buffer_list_get (list, 0);
+  last = gst_buffer_list_get (list, len - 1);
+  n_buffers = len;
+
+  if (!throughput->histograms && !throughput->frame_types &&
+      !throughput->memory && !throughput->drop_buffer_flags) {
+    for (i = 0; i < len; i++)
+      size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+  } else {
+    GstBuffer *buf;
+    gsize buf_size;
+
+    first = last = NULL;
+    n_buffers = 0;
+    for (i = 0; i < len; i++) {
+      buf = gst_buffer_list_get (list, i);
+      if (GST_BUFFER_FLAGS (buf) & throughput->drop_buffer_flags)
+        continue;
+
+      buf_size = gst_buffer_get_size (buf);
+      if (throughput->histograms)
+        gst_timing_histogram_record (&throughput->sizes, buf_size);
+      if (throughput->frame_types)
+        gst_throughput_classify (throughput, buf, buf_size);
+      if (throughput->memory)
+        gst_throughput_inspect_memory (throughput, buf);
+
+      if (!first)
+        first = buf;
+      last = buf;
+      n_buffers++;
+      size += buf_size;
+    }
+
+    if (throughput->histograms && n_buffers)
+      gst_throughput_record_arrival (throughput);
+  }
+
+  /* a list is checked and synced as a whole, by its first buffer */
+  running_time = gst_throughput_running_time (trans,
+      gst_buffer_list_get (list, 0));
+
+  if (n_buffers) {
+    gst_throughput_count (throughput, first, last, n_buffers, size);
+
+    if (throughput->lateness)
+      gst_throughput_check_deadline (throughput, first);
+  }
+
+  ret = gst_throughput_do_sync (throughput, running_time);
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_list_unref (list);
+    return ret;
+  }
+
+  /* the list is gone once pushed */
+  position = gst_throughput_list_position (trans, list);
+
+  if (throughput->backpressure)
+    throughput->push_start = gst_throughput_now (throughput);
+  ret = gst_pad_push_list (trans->srcpad, list);
+  if (throughput->backpressure)
+    gst_throughput_backpressure_leave (throughput);
+
+  /* as GstBaseTransform does for every buffer it pushed */
+  if (ret == GST_FLOW_OK && GST_CLOCK_TIME_IS_VALID (position))
+    trans->segment.position = position;
 
   return ret;
 }
@@ -452,8 +1951,68 @@ gst_throughput_set_property (GObject * object, guint prop_id,
     case PROP_STDERR:
       throughput->stderr = g_value_get_boolean (value);
       break;
-    case PROP_INTERVAL:
+    case PROP_INTERVAL:{
+      GstClock *clock = NULL;
+
+      GST_OBJECT_LOCK (throughput);
       throughput->interval = g_value_get_uint (value);
+      if (throughput->group && throughput->measure_clock)
+        clock = gst_object_ref (throughput->measure_clock);
+      GST_OBJECT_UNLOCK (throughput);
+
+      /* while running, move over to the group of the new interval */
+      if (clock) {
+        gst_throughput_use_clock (throughput, clock);
+        gst_object_unref (clock);
+      }
+      break;
+    }
+    case PROP_SILENT:
+      throughput->silent = g_value_get_boolean (value);
+      break;
+    case PROP_POST_MESSAGES:
+      throughput->post_messages = g_value_get_boolean (value);
+      break;
+    case PROP_HISTOGRAMS:
+      throughput->histograms = g_value_get_boolean (value);
+      break;
+    case PROP_WINDOWS:
+      gst_throughput_set_windows (throughput, g_value_get_string (value));
+      break;
+    case PROP_EWMA_TIME_CONSTANT:
+      GST_OBJECT_LOCK (throughput);
+      throughput->ewma_time_constant = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (throughput);
+      break;
+    case PROP_CLOCK_SOURCE:
+      throughput->clock_source = g_value_get_enum (value);
+      break;
+    case PROP_SYNC_EVERY:
+      throughput->sync_every = g_value_get_uint (value);
+      break;
+    case PROP_LATENESS:
+      throughput->lateness = g_value_get_boolean (value);
+      break;
+    case PROP_QOS:
+      throughput->qos = g_value_get_boolean (value);
+      break;
+    case PROP_FRAME_TYPES:
+      throughput->frame_types = g_value_get_boolean (value);
+      break;
+    case PROP_IGNORE_FLAGS:
+      throughput->drop_buffer_flags = g_value_get_flags (value);
+      break;
+    case PROP_BACKPRESSURE:
+      throughput->backpressure = g_value_get_boolean (value);
+      break;
+    case PROP_MEMORY:
+      throughput->memory = g_value_get_boolean (value);
+      break;
+    case PROP_SHM_DIR:
+      GST_OBJECT_LOCK (throughput);
+      g_free (throughput->shm_dir);
+      throughput->shm_dir = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (throughput);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -483,7 +2042,69 @@ gst_throughput_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_boolean (value, throughput->stderr);
       break;
     case PROP_INTERVAL:
+      GST_OBJECT_LOCK (throughput);
       g_value_set_uint (value, throughput->interval);
+      GST_OBJECT_UNLOCK (throughput);
+      break;
+    case PROP_SILENT:
+      g_value_set_boolean (value, throughput->silent);
+      break;
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, throughput->post_messages);
+      break;
+    case PROP_HISTOGRAMS:
+      g_value_set_boolean (value, throughput->histograms);
+      break;
+    case PROP_WINDOWS:
+    {
+      GString *windows = g_string_new (NULL);
+      guint i;
+
+      GST_OBJECT_LOCK (throughput);
+      for (i = 0; i < throughput->n_windows; i++)
+        g_string_append_printf (windows, "%s%u", i ? "," : "",
+            throughput->windows[i]);
+      GST_OBJECT_UNLOCK (throughput);
+
+      g_value_take_string (value, g_string_free (windows, FALSE));
+      break;
+    }
+    case PROP_EWMA_TIME_CONSTANT:
+      g_value_set_uint (value, throughput->ewma_time_constant);
+      break;
+    case PROP_STATS:
+      GST_OBJECT_LOCK (throughput);
+      g_value_set_boxed (value, throughput->stats);
+      GST_OBJECT_UNLOCK (throughput);
+      break;
+    case PROP_CLOCK_SOURCE:
+      g_value_set_enum (value, throughput->clock_source);
+      break;
+    case PROP_SYNC_EVERY:
+      g_value_set_uint (value, throughput->sync_every);
+      break;
+    case PROP_LATENESS:
+      g_value_set_boolean (value, throughput->lateness);
+      break;
+    case PROP_QOS:
+      g_value_set_boolean (value, throughput->qos);
+      break;
+    case PROP_FRAME_TYPES:
+      g_value_set_boolean (value, throughput->frame_types);
+      break;
+    case PROP_IGNORE_FLAGS:
+      g_value_set_flags (value, throughput->drop_buffer_flags);
+      break;
+    case PROP_BACKPRESSURE:
+      g_value_set_boolean (value, throughput->backpressure);
+      break;
+    case PROP_MEMORY:
+      g_value_set_boolean (value, throughput->memory);
+      break;
+    case PROP_SHM_DIR:
+      GST_OBJECT_LOCK (throughput);
+      g_value_set_string (value, throughput->shm_dir);
+      GST_OBJECT_UNLOCK (throughput);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -491,18 +2112,157 @@ gst_throughput_get_property (GObject * object, guint prop_id, GValue * value,
   }
 }
 
+/* publishes @clock in @slot for the lock-free readers, the clock it
+ * replaces is only released in stop, when nothing streams anymore. Must be
+ * called with the object lock. */
+static void
+gst_throughput_replace_clock (GstThroughput * throughput, GstClock ** slot,
+    GstClock * clock)
+{
+  GstClock *old = *slot;
+
+  if (old == clock)
+    return;
+
+  if (clock)
+    gst_object_ref (clock);
+  g_atomic_pointer_set (slot, clock);
+  if (old)
+    throughput->retired_clocks =
+        g_slist_prepend (throughput->retired_clocks, old);
+}
+
+/* moves the measurements and the reports to @clock, or stops them until a
+ * clock is known with clock == NULL. An interval never spans two clocks.
+ * The reports are ticked together with all other elements on the same clock
+ * with the same interval. */
+static void
+gst_throughput_use_clock (GstThroughput * throughput, GstClock * clock)
+{
+  GstTimingGroup *group;
+  guint interval;
+
+  GST_OBJECT_LOCK (throughput);
+  group = throughput->group;
+  throughput->group = NULL;
+  GST_OBJECT_UNLOCK (throughput);
+
+  if (group)
+    gst_timing_registry_leave (group, GST_OBJECT_CAST (throughput));
+
+  GST_OBJECT_LOCK (throughput);
+  gst_throughput_replace_clock (throughput, &throughput->measure_clock,
+      clock);
+  throughput->meter.last.timestamp = GST_CLOCK_TIME_NONE;
+  throughput->prev_arrival = GST_CLOCK_TIME_NONE;
+  interval = throughput->interval;
+  GST_OBJECT_UNLOCK (throughput);
+
+  if (!clock)
+    return;
+
+  group = gst_timing_registry_join (GST_OBJECT_CAST (throughput),
+      gst_throughput_report, clock, interval);
+
+  GST_OBJECT_LOCK (throughput);
+  throughput->group = group;
+  GST_OBJECT_UNLOCK (throughput);
+}
+
+static gboolean
+gst_throughput_set_clock (GstElement * element, GstClock * clock)
+{
+  GstThroughput *throughput = GST_THROUGHPUT (element);
+  gboolean changed;
+
+  GST_OBJECT_LOCK (throughput);
+  gst_throughput_replace_clock (throughput, &throughput->element_clock, clock);
+  changed = throughput->started && throughput->measure_clock != clock;
+  GST_OBJECT_UNLOCK (throughput);
+
+  if (changed &&
+      throughput->clock_source == GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE) {
+    GST_DEBUG_OBJECT (throughput, "measuring with %" GST_PTR_FORMAT, clock);
+    gst_throughput_use_clock (throughput, clock);
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->set_clock (element, clock);
+}
+
 static gboolean
 gst_throughput_start (GstBaseTransform * trans)
 {
   GstThroughput *throughput;
+  GstClock *clock;
 
   throughput = GST_THROUGHPUT (trans);
 
   throughput->offset = 0;
   throughput->prev_timestamp = GST_CLOCK_TIME_NONE;
   throughput->prev_duration = GST_CLOCK_TIME_NONE;
-  throughput->prev_offset_end = GST_BUFFER_OFFSET_NONE;
-  throughput->prev_offset = GST_BUFFER_OFFSET_NONE;
+  throughput->prev_arrival = GST_CLOCK_TIME_NONE;
+  throughput->running_position = GST_CLOCK_TIME_NONE;
+  throughput->stream_position = GST_CLOCK_TIME_NONE;
+  throughput->sync_count = 0;
+  throughput->qos_running_time = GST_CLOCK_TIME_NONE;
+  throughput->have_prev = FALSE;
+  memset (&throughput->loss, 0, sizeof (throughput->loss));
+  memset (&throughput->frames, 0, sizeof (throughput->frames));
+  throughput->have_keyframe = FALSE;
+  throughput->frames_since_keyframe = 0;
+  throughput->prev_keyframe_pts = GST_CLOCK_TIME_NONE;
+  throughput->push_start = GST_CLOCK_TIME_NONE;
+  throughput->prev_push_end = GST_CLOCK_TIME_NONE;
+  throughput->blocked_time = 0;
+  throughput->starved_time = 0;
+  memset (&throughput->memory_counts, 0, sizeof (throughput->memory_counts));
+  memset (throughput->seen_memories, 0, sizeof (throughput->seen_memories));
+
+  GST_OBJECT_LOCK (throughput);
+  memset (&throughput->loss_last, 0, sizeof (throughput->loss_last));
+  throughput->last_running_position = GST_CLOCK_TIME_NONE;
+  throughput->duration = GST_CLOCK_TIME_NONE;
+  throughput->duration_stale = TRUE;
+  gst_timing_histogram_reset (&throughput->gaps);
+  gst_timing_histogram_reset (&throughput->sizes);
+  gst_timing_histogram_view_init (&throughput->gaps_view);
+  gst_timing_histogram_view_init (&throughput->sizes_view);
+  gst_timing_histogram_reset (&throughput->lateness_histogram);
+  gst_timing_histogram_view_init (&throughput->lateness_view);
+  gst_timing_histogram_reset (&throughput->gop_lengths);
+  gst_timing_histogram_view_init (&throughput->gop_lengths_view);
+  gst_timing_histogram_reset (&throughput->keyframe_intervals);
+  gst_timing_histogram_view_init (&throughput->keyframe_intervals_view);
+  memset (&throughput->frames_last, 0, sizeof (throughput->frames_last));
+  gst_timing_histogram_reset (&throughput->push_durations);
+  gst_timing_histogram_view_init (&throughput->push_durations_view);
+  throughput->blocked_time_last = 0;
+  throughput->starved_time_last = 0;
+  gst_timing_histogram_reset (&throughput->memories_per_buffer);
+  gst_timing_histogram_view_init (&throughput->memories_per_buffer_view);
+  memset (&throughput->memory_last, 0, sizeof (throughput->memory_last));
+  gst_throughput_meter_init (&throughput->meter);
+  GST_OBJECT_UNLOCK (throughput);
+
+  if (!gst_throughput_shm_open (throughput))
+    return FALSE;
+
+  gst_throughput_clock_source_init (GST_OBJECT_CAST (throughput),
+      throughput->clock_source, &throughput->time_source);
+
+  if (throughput->clock_source == GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE)
+    clock = gst_element_get_clock (GST_ELEMENT_CAST (throughput));
+  else
+    clock = gst_system_clock_obtain ();
+
+  GST_OBJECT_LOCK (throughput);
+  throughput->started = TRUE;
+  GST_OBJECT_UNLOCK (throughput);
+
+  /* without a pipeline clock yet, set_clock starts the measurements */
+  gst_throughput_use_clock (throughput, clock);
+  if (clock)
+    gst_object_unref (clock);
 
   return TRUE;
 }
@@ -515,13 +2275,70 @@ gst_throughput_stop (GstBaseTransform * trans)
   throughput = GST_THROUGHPUT (trans);
 
   GST_OBJECT_LOCK (throughput);
+  throughput->started = FALSE;
+  GST_OBJECT_UNLOCK (throughput);
+
+  gst_throughput_use_clock (throughput, NULL);
+  gst_throughput_shm_close (throughput);
+
+  GST_OBJECT_LOCK (throughput);
+  if (throughput->clock_id)
+    gst_clock_id_unref (throughput->clock_id);
+  throughput->clock_id = NULL;
+  gst_object_replace ((GstObject **) & throughput->sync_clock, NULL);
+  /* the streaming thread is gone, nothing reads the replaced clocks */
+  g_slist_free_full (throughput->retired_clocks, gst_object_unref);
+  throughput->retired_clocks = NULL;
   g_free (throughput->last_message);
   throughput->last_message = NULL;
+  if (throughput->stats)
+    gst_structure_free (throughput->stats);
+  throughput->stats = NULL;
   GST_OBJECT_UNLOCK (throughput);
 
   return TRUE;
 }
 
+static void
+gst_throughput_set_windows (GstThroughput * throughput, const gchar * windows)
+{
+  gchar **parts;
+  guint i, n = 0;
+  guint64 window;
+
+  parts = g_strsplit (windows ? windows : "", ",", -1);
+
+  GST_OBJECT_LOCK (throughput);
+  for (i = 0; parts[i] && n < GST_THROUGHPUT_MAX_WINDOWS; i++) {
+    window = g_ascii_strtoull (g_strstrip (parts[i]), NULL, 10);
+    if (window == 0 || window > G_MAXUINT) {
+      GST_WARNING_OBJECT (throughput, "ignoring invalid window '%s'",
+          parts[i]);
+      continue;
+    }
+    throughput->windows[n++] = (guint) window;
+  }
+  throughput->n_windows = n;
+  GST_OBJECT_UNLOCK (throughput);
+
+  g_strfreev (parts);
+}
+
+static void
+gst_throughput_reset (GstThroughput * throughput)
+{
+  GST_OBJECT_LOCK (throughput);
+  gst_timing_histogram_view_reset_total (&throughput->gaps_view);
+  gst_timing_histogram_view_reset_total (&throughput->sizes_view);
+  gst_timing_histogram_view_reset_total (&throughput->lateness_view);
+  gst_timing_histogram_view_reset_total (&throughput->gop_lengths_view);
+  gst_timing_histogram_view_reset_total (&throughput->keyframe_intervals_view);
+  gst_timing_histogram_view_reset_total (&throughput->push_durations_view);
+  gst_timing_histogram_view_reset_total
+      (&throughput->memories_per_buffer_view);
+  GST_OBJECT_UNLOCK (throughput);
+}
+
 static gboolean
 gst_throughput_accept_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps)
@@ -607,7 +2424,7 @@ gst_throughput_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       GST_OBJECT_LOCK (throughput);
-      if (throughput->clock_id) {
+      if (throughput->sync_waiting) {
         GST_DEBUG_OBJECT (throughput, "unlock clock wait");
         gst_clock_id_unschedule (throughput->clock_id);
       }
@@ -22,6 +22,13 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
 
+#include "gsttimingcounter.h"
+#include "gsttiminghistogram.h"
+#include "gsttimingregistry.h"
+#include "gsttimingtimesource.h"
+#include "gstthroughputmeter.h"
+#include "gstthroughputshm.h"
+
 G_BEGIN_DECLS
 
 
@@ -36,18 +43,64 @@ G_BEGIN_DECLS
 #define GST_IS_THROUGHPUT_CLASS(klass) \
   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_THROUGHPUT))
 
-typedef struct _GstThroughput GstThroughput;
-typedef struct _GstThroughputClass GstThroughputClass;
-typedef struct _GstThroughputMeasurement GstThroughputMeasurement;
+#define GST_THROUGHPUT_MAX_WINDOWS 8
+#define GST_THROUGHPUT_MAX_ALLOCATORS 8
+#define GST_THROUGHPUT_MEMORY_CACHE 256
 
+/**
+ * GstThroughputClockSource:
+ * @GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM: the #GstSystemClock
+ * @GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE: the clock of the pipeline, e.g. a
+ *   #GstTestClock in tests
+ * @GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC: CLOCK_MONOTONIC, read directly
+ * @GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC_COARSE: CLOCK_MONOTONIC_COARSE
+ * @GST_THROUGHPUT_CLOCK_SOURCE_TSC: the calibrated time stamp counter
+ *
+ * Where #GstThroughput takes the wall-clock times of its measurements from.
+ */
+typedef enum {
+  GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM,
+  GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE,
+  GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC,
+  GST_THROUGHPUT_CLOCK_SOURCE_MONOTONIC_COARSE,
+  GST_THROUGHPUT_CLOCK_SOURCE_TSC
+} GstThroughputClockSource;
 
-struct _GstThroughputMeasurement {
-  GstClockTime   timestamp;
+/* Counters of what did not arrive, written by the streaming thread only */
+typedef struct {
+  guint64        missing_offsets;
+  GstClockTime   missing_time;
+  guint64        discont_buffers;
+  guint64        gap_events;
+  GstClockTime   gap_time;
+} GstThroughputLoss;
+
+/* Counters of a compressed stream by frame type, written by the streaming
+ * thread only */
+typedef struct {
+  guint64        keyframes;
+  guint64        keyframe_bytes;
+  guint64        delta_frames;
+  guint64        delta_bytes;
+  guint64        header_buffers;
+  guint64        header_bytes;
+} GstThroughputFrames;
+
+/* Counters of the memory behind the buffers, written by the streaming
+ * thread only. An allocator slot's type is set once, the last slot counts
+ * all types that did not fit */
+typedef struct {
+  guint64        memories;
+  guint64        pooled_buffers;
+  guint64        recycled_memories;
+  guint64        fresh_memories;
+  const gchar   *allocator_types[GST_THROUGHPUT_MAX_ALLOCATORS];
+  guint64        allocator_memories[GST_THROUGHPUT_MAX_ALLOCATORS];
+} GstThroughputMemory;
+
+typedef struct _GstThroughput GstThroughput;
+typedef struct _GstThroughputClass GstThroughputClass;
 
-  guint64        count_offsets;
-  guint64        count_buffers;
-  guint64        count_bytes;
-};
 /**
  * GstThroughput:
  *
@@ -58,34 +111,146 @@ struct _GstThroughput {
 
   /*< private >*/
   GstClockID     clock_id;
+  GstClock       *sync_clock;
+  gboolean       sync_waiting;
+  guint          sync_every;
+  guint64        sync_count;
   gboolean       sync;
   gboolean       stderr;
-  guint          interval;
+  gboolean       silent;
+  gboolean       post_messages;
   GstBufferFlags drop_buffer_flags;
   GstClockTime   prev_timestamp;
   GstClockTime   prev_duration;
-  guint64        prev_offset;
-  guint64        prev_offset_end;
+  gboolean       have_prev;
   gchar          *last_message;
+  GstStructure   *stats;
   guint64        offset;
   gboolean       signal_handoffs;
   GstClockTime   upstream_latency;
   GCond          blocked_cond;
   gboolean       blocked;
 
-  GstCaps        *video_caps;
-  GstCaps        *audio_caps;
+  GstThroughputMeter meter;
 
-  GstThroughputMeasurement measurement;
-  GstThroughputMeasurement last_measurement;
+  /* report interval in ms and the registry group that ticks the reports,
+   * protected by the object lock */
+  guint          interval;
+  GstTimingGroup *group;
+
+  gboolean       histograms;
+  GstThroughputClockSource clock_source;
+  gboolean       started;
+  /* clock all wall-clock times are taken from and the pipeline clock the
+   * deadlines are checked against. Replaced under the object lock, but read
+   * by the streaming thread with an atomic load and without a ref: replaced
+   * clocks are kept alive in retired_clocks until stop */
+  GstClock       *measure_clock;
+  GstClock       *element_clock;
+  GSList         *retired_clocks;
+  /* the other clock sources, set up in start */
+  GstTimingTimeSource time_source;
+
+  /* end of the last buffer, written by the streaming thread only */
+  GstClockTime   running_position;
+  GstClockTime   stream_position;
+  /* reporter side, protected by the object lock */
+  GstClockTime   last_running_position;
+  /* upstream duration, queried by the streaming thread once the reporter or
+   * a new segment marked it stale, protected by the object lock */
+  GstClockTime   duration;
+  gint           duration_stale;
+
+  GstThroughputLoss loss;
+  /* reporter side, protected by the object lock */
+  GstThroughputLoss loss_last;
+
+  /* frame types, the histograms are written by the streaming thread only */
+  gboolean       frame_types;
+  gboolean       have_keyframe;
+  guint64        frames_since_keyframe;
+  GstClockTime   prev_keyframe_pts;
+  GstThroughputFrames frames;
+  GstTimingHistogram gop_lengths;
+  GstTimingHistogram keyframe_intervals;
+  /* reporter side, protected by the object lock */
+  GstThroughputFrames frames_last;
+  GstTimingHistogramView gop_lengths_view;
+  GstTimingHistogramView keyframe_intervals_view;
+
+  GstClockTime   prev_arrival;
+  /* written by the streaming thread only */
+  GstTimingHistogram gaps;
+  GstTimingHistogram sizes;
+  /* reporter side, protected by the object lock */
+  GstTimingHistogramView gaps_view;
+  GstTimingHistogramView sizes_view;
+
+  /* deadline monitor, histogram written by the streaming thread only */
+  gboolean       lateness;
+  gboolean       qos;
+  GstClockTime   qos_running_time;
+  GstTimingHistogram lateness_histogram;
+  GstTimingHistogramView lateness_view;
+
+  /* memory diagnostics, written by the streaming thread only */
+  gboolean       memory;
+  GstThroughputMemory memory_counts;
+  GstMemory      *seen_memories[GST_THROUGHPUT_MEMORY_CACHE];
+  GstTimingHistogram memories_per_buffer;
+  /* reporter side, protected by the object lock */
+  GstThroughputMemory memory_last;
+  GstTimingHistogramView memories_per_buffer_view;
+
+  /* backpressure, written by the streaming thread only */
+  gboolean       backpressure;
+  GstPadChainFunction base_chain;
+  GstClockTime   push_start;
+  GstClockTime   prev_push_end;
+  guint64        blocked_time;
+  guint64        starved_time;
+  GstTimingHistogram push_durations;
+  /* reporter side, protected by the object lock */
+  guint64        blocked_time_last;
+  guint64        starved_time_last;
+  GstTimingHistogramView push_durations_view;
+
+  /* sliding windows and moving average, reporter side, protected by the
+   * object lock */
+  guint          windows[GST_THROUGHPUT_MAX_WINDOWS];
+  guint          n_windows;
+  guint          ewma_time_constant;
+  GstThroughputMeasurement *history;
+  guint          history_size;
+  guint          history_len;
+  guint          history_head;
+  gboolean       have_ewma;
+  gdouble        ewma_buffers;
+  gdouble        ewma_bytes;
+  gdouble        ewma_offsets;
+
+  /* published stats, protected by the object lock */
+  gchar          *shm_dir;
+  GstThroughputShm *shm;
+  gchar          *shm_path;
 };
 
 struct _GstThroughputClass {
   GstBaseTransformClass parent_class;
+
+  /* actions */
+  void (*reset) (GstThroughput * throughput);
 };
 
 G_GNUC_INTERNAL GType gst_throughput_get_type (void);
 
+/* the clock-source enum and its setup, shared with throughputmux */
+#define GST_TYPE_THROUGHPUT_CLOCK_SOURCE \
+  (gst_throughput_clock_source_get_type ())
+G_GNUC_INTERNAL GType gst_throughput_clock_source_get_type (void);
+G_GNUC_INTERNAL void gst_throughput_clock_source_init (GstObject * object,
+    GstThroughputClockSource clock_source, GstTimingTimeSource * time_source);
+
 G_END_DECLS
 
 #endif /* __GST_THROUGHPUT_H__ */
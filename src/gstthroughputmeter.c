@@ -0,0 +1,171 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/video/video.h>
+#include <gst/audio/audio.h>
+
+#include "gstthroughputmeter.h"
+
+/* resets counters and stream info, only while nothing is counting */
+void
+gst_throughput_meter_init (GstThroughputMeter * meter)
+{
+  meter->info.kind = GST_THROUGHPUT_MEDIA_OTHER;
+  meter->info.rate = 0.0;
+  meter->info.bytes_per_unit = 0;
+  meter->info.expected_bitrate = 0.0;
+
+  meter->measurement.timestamp = GST_CLOCK_TIME_NONE;
+  meter->measurement.count_offsets = 0;
+  meter->measurement.count_buffers = 0;
+  meter->measurement.count_bytes = 0;
+  meter->last = meter->measurement;
+
+  gst_throughput_meter_discont (meter);
+}
+
+void
+gst_throughput_stream_info_from_caps (GstThroughputStreamInfo * info,
+    GstCaps * caps)
+{
+  GstStructure *s;
+
+  info->kind = GST_THROUGHPUT_MEDIA_OTHER;
+  info->rate = 0.0;
+  info->bytes_per_unit = 0;
+  info->expected_bitrate = 0.0;
+
+  if (gst_caps_is_empty (caps) || gst_caps_is_any (caps))
+    return;
+
+  /* Matched on the media type alone, unlike the subset check against plain
+   * video/x-raw and audio/x-raw this replaced: raw media with caps features
+   * such as memory:GLMemory or memory:DMABuf is still one frame per buffer
+   * and has a nominal rate. CAPS events always carry fixed caps, so the
+   * first structure is the only one. */
+  s = gst_caps_get_structure (caps, 0);
+  if (gst_structure_has_name (s, "video/x-raw")) {
+    GstVideoInfo vinfo;
+    gint num, denom;
+
+    info->kind = GST_THROUGHPUT_MEDIA_VIDEO;
+    if (gst_structure_get_fraction (s, "framerate", &num, &denom) &&
+        num > 0 && denom > 0)
+      gst_util_fraction_to_double (num, denom, &info->rate);
+
+    if (gst_video_info_from_caps (&vinfo, caps))
+      info->bytes_per_unit = GST_VIDEO_INFO_SIZE (&vinfo);
+  } else if (gst_structure_has_name (s, "audio/x-raw")) {
+    GstAudioInfo ainfo;
+    gint rate;
+
+    info->kind = GST_THROUGHPUT_MEDIA_AUDIO;
+    if (gst_structure_get_int (s, "rate", &rate) && rate > 0)
+      info->rate = rate;
+
+    if (gst_audio_info_from_caps (&ainfo, caps))
+      info->bytes_per_unit = GST_AUDIO_INFO_BPF (&ainfo);
+  }
+
+  /* width x height x format x framerate, or rate x channels x width */
+  info->expected_bitrate = info->rate * info->bytes_per_unit * 8;
+}
+
+const gchar *
+gst_throughput_media_kind_name (GstThroughputMediaKind kind)
+{
+  switch (kind) {
+    case GST_THROUGHPUT_MEDIA_VIDEO:
+      return "video";
+    case GST_THROUGHPUT_MEDIA_AUDIO:
+      return "audio";
+    default:
+      return "other";
+  }
+}
+
+/* reads the live counters, called from the reporter */
+void
+gst_throughput_meter_snapshot (GstThroughputMeter * meter, GstClockTime now,
+    GstThroughputMeasurement * measurement)
+{
+  measurement->timestamp = now;
+  measurement->count_buffers =
+      GST_TIMING_COUNTER_GET (meter->measurement.count_buffers);
+  measurement->count_bytes =
+      GST_TIMING_COUNTER_GET (meter->measurement.count_bytes);
+  measurement->count_offsets =
+      GST_TIMING_COUNTER_GET (meter->measurement.count_offsets);
+}
+
+/* Builds the stats of the interval between meter->last and measurement.
+ * Returns NULL if there is no such interval yet, because nothing has flowed
+ * or this is the first snapshot. Does not update meter->last, the caller
+ * does so once it is done with both. */
+GstStructure *
+gst_throughput_meter_stats (GstThroughputMeter * meter,
+    const GstThroughputMeasurement * measurement, const gchar * name)
+{
+  const GstThroughputMeasurement *last = &meter->last;
+  GstStructure *stats;
+  GstClockTime tdelta;
+  gdouble f, bitrate;
+
+  if (last->timestamp == GST_CLOCK_TIME_NONE ||
+      measurement->count_buffers == 0 ||
+      measurement->timestamp <= last->timestamp)
+    return NULL;
+
+  tdelta = measurement->timestamp - last->timestamp;
+  f = (gdouble) GST_SECOND / (gdouble) tdelta;
+  bitrate = f * (measurement->count_bytes - last->count_bytes) * 8;
+
+  stats = gst_structure_new (name,
+      "timestamp", G_TYPE_UINT64, measurement->timestamp,
+      "interval", G_TYPE_UINT64, tdelta,
+      "media-kind", G_TYPE_STRING,
+      gst_throughput_media_kind_name (meter->info.kind),
+      "nominal-rate", G_TYPE_DOUBLE, meter->info.rate,
+      "buffers", G_TYPE_UINT64, measurement->count_buffers,
+      "bytes", G_TYPE_UINT64, measurement->count_bytes,
+      "offsets", G_TYPE_UINT64, measurement->count_offsets,
+      "interval-buffers", G_TYPE_UINT64,
+      measurement->count_buffers - last->count_buffers,
+      "interval-bytes", G_TYPE_UINT64,
+      measurement->count_bytes - last->count_bytes,
+      "interval-offsets", G_TYPE_UINT64,
+      measurement->count_offsets - last->count_offsets,
+      "buffers-per-second", G_TYPE_DOUBLE,
+      f * (measurement->count_buffers - last->count_buffers),
+      "bytes-per-second", G_TYPE_DOUBLE,
+      f * (measurement->count_bytes - last->count_bytes),
+      "bits-per-second", G_TYPE_DOUBLE, bitrate,
+      "offsets-per-second", G_TYPE_DOUBLE,
+      f * (measurement->count_offsets - last->count_offsets),
+      "expected-bits-per-second", G_TYPE_DOUBLE, meter->info.expected_bitrate,
+      NULL);
+
+  /* how much of the raw bitrate the caps promise actually went through */
+  if (meter->info.expected_bitrate > 0.0)
+    gst_structure_set (stats, "efficiency", G_TYPE_DOUBLE,
+        bitrate / meter->info.expected_bitrate, NULL);
+
+  return stats;
+}
@@ -0,0 +1,158 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_THROUGHPUT_METER_H__
+#define __GST_THROUGHPUT_METER_H__
+
+#include <gst/gst.h>
+
+#include "gsttimingcounter.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GstThroughputMeasurement GstThroughputMeasurement;
+typedef struct _GstThroughputStreamInfo GstThroughputStreamInfo;
+typedef struct _GstThroughputMeter GstThroughputMeter;
+
+typedef enum {
+  GST_THROUGHPUT_MEDIA_OTHER,
+  GST_THROUGHPUT_MEDIA_VIDEO,
+  GST_THROUGHPUT_MEDIA_AUDIO
+} GstThroughputMediaKind;
+
+/* derived from the caps once per CAPS event, read for every buffer */
+struct _GstThroughputStreamInfo {
+  GstThroughputMediaKind kind;
+
+  /* frames or samples per second as announced in the caps, 0 if unknown */
+  gdouble        rate;
+  /* bytes per frame or per sample (all channels), 0 if unknown */
+  gsize          bytes_per_unit;
+  /* bits per second of the uncompressed stream at the nominal rate, 0 if
+   * unknown */
+  gdouble        expected_bitrate;
+};
+
+struct _GstThroughputMeasurement {
+  GstClockTime   timestamp;
+
+  guint64        count_offsets;
+  guint64        count_buffers;
+  guint64        count_bytes;
+};
+
+/* The counting core shared by the throughput element, throughputmux, the
+ * padthroughput tracer and the throughput probe. info, measurement and the
+ * previous offsets are written by the streaming thread, last is the
+ * snapshot the reporter took at the end of the previous interval. */
+struct _GstThroughputMeter {
+  GstThroughputStreamInfo info;
+  GstThroughputMeasurement measurement;
+  GstThroughputMeasurement last;
+
+  guint64        prev_offset;
+  guint64        prev_offset_end;
+};
+
+static inline void
+gst_throughput_meter_count (GstThroughputMeter * meter, guint n_buffers,
+    gsize size, guint64 offset_delta)
+{
+  GstThroughputMeasurement *m = &meter->measurement;
+
+  GST_TIMING_COUNTER_ADD (m->count_buffers, n_buffers);
+  GST_TIMING_COUNTER_ADD (m->count_bytes, size);
+  if (meter->info.kind != GST_THROUGHPUT_MEDIA_OTHER)
+    GST_TIMING_COUNTER_ADD (m->count_offsets, offset_delta);
+}
+
+/* Frames or samples in buffers that carry no offsets: one frame per raw
+ * video buffer, the size in whole samples for raw audio, else the time
+ * spanned from first to last at the nominal rate */
+static inline guint64
+gst_throughput_meter_units (GstThroughputMeter * meter, GstBuffer * first,
+    GstBuffer * last, guint n_buffers, gsize size)
+{
+  const GstThroughputStreamInfo *info = &meter->info;
+  GstClockTime start = GST_BUFFER_PTS (first), end = GST_BUFFER_PTS (last);
+
+  if (info->kind == GST_THROUGHPUT_MEDIA_VIDEO)
+    return n_buffers;
+  if (info->bytes_per_unit > 0)
+    return size / info->bytes_per_unit;
+
+  if (info->rate <= 0.0 || !GST_CLOCK_TIME_IS_VALID (start) ||
+      !GST_CLOCK_TIME_IS_VALID (end) || !GST_BUFFER_DURATION_IS_VALID (last))
+    return 0;
+  end += GST_BUFFER_DURATION (last);
+  if (end <= start)
+    return 0;
+
+  return (guint64) (info->rate * (end - start) / GST_SECOND + 0.5);
+}
+
+/* Counts a buffer or a buffer list from first to last. Frames or samples
+ * come from the offsets since the previous buffer, without the ones skipped
+ * after its offset-end, which are returned as missing instead of counted as
+ * transferred. */
+static inline guint64
+gst_throughput_meter_count_buffers (GstThroughputMeter * meter,
+    GstBuffer * first, GstBuffer * last, guint n_buffers, gsize size)
+{
+  guint64 offset = GST_BUFFER_OFFSET (first), offset_delta = 0, missing = 0;
+
+  if (offset != GST_BUFFER_OFFSET_NONE &&
+      meter->prev_offset_end != GST_BUFFER_OFFSET_NONE &&
+      offset > meter->prev_offset_end)
+    missing = offset - meter->prev_offset_end;
+
+  if (GST_BUFFER_OFFSET (last) == GST_BUFFER_OFFSET_NONE)
+    offset_delta = gst_throughput_meter_units (meter, first, last, n_buffers,
+        size);
+  else if (meter->prev_offset != GST_BUFFER_OFFSET_NONE &&
+      GST_BUFFER_OFFSET (last) > meter->prev_offset)
+    offset_delta = GST_BUFFER_OFFSET (last) - meter->prev_offset;
+  offset_delta -= MIN (offset_delta, missing);
+
+  meter->prev_offset = GST_BUFFER_OFFSET (last);
+  meter->prev_offset_end = GST_BUFFER_OFFSET_END (last);
+  gst_throughput_meter_count (meter, n_buffers, size, offset_delta);
+
+  return missing;
+}
+
+/* a new segment, the offsets start over */
+static inline void
+gst_throughput_meter_discont (GstThroughputMeter * meter)
+{
+  meter->prev_offset = GST_BUFFER_OFFSET_NONE;
+  meter->prev_offset_end = GST_BUFFER_OFFSET_NONE;
+}
+
+G_GNUC_INTERNAL void gst_throughput_meter_init (GstThroughputMeter * meter);
+G_GNUC_INTERNAL void gst_throughput_stream_info_from_caps (
+    GstThroughputStreamInfo * info, GstCaps * caps);
+G_GNUC_INTERNAL const gchar * gst_throughput_media_kind_name (
+    GstThroughputMediaKind kind);
+G_GNUC_INTERNAL void gst_throughput_meter_snapshot (GstThroughputMeter * meter,
+    GstClockTime now, GstThroughputMeasurement * measurement);
+G_GNUC_INTERNAL GstStructure * gst_throughput_meter_stats (
+    GstThroughputMeter * meter, const GstThroughputMeasurement * measurement,
+    const gchar * name);
+
+G_END_DECLS
+
+#endif /* __GST_THROUGHPUT_METER_H__ */
@@ -0,0 +1,808 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/**
+ * SECTION:element-throughputmux
+ *
+ * Measures many streams at once in a single element. Every requested
+ * sink_%u pad gets a matching src_%u pad, data and events pass from one to
+ * the other unmodified and every stream is counted on its own, the same way
+ * throughput counts a single one.
+ *
+ * The counters of all streams live in one array of cache line sized slots
+ * allocated up front for #GstThroughputMux:max-streams streams, so a buffer
+ * costs the same no matter how many streams there are and takes no lock.
+ * Every #GstThroughputMux:interval milliseconds a single #GstStructure named
+ * "throughputmux" is made available through #GstThroughputMux:stats and as
+ * an element message, with the totals over all streams and a "streams"
+ * array holding the usual throughput stats of every stream, each named after
+ * its sink pad. The human readable #GstThroughputMux:last-message only sums
+ * up all streams and names the slowest one.
+ *
+ * Like throughput, the mux takes its times from #GstThroughputMux:clock-source
+ * and joins the reports of all elements on the same clock with the same
+ * interval, so its intervals end at the same time as theirs and its stats
+ * are part of their combined "throughput-report".
+ *
+ * |[
+ * gst-launch-1.0 throughputmux name=m silent=false \
+ *     rtspsrc location=rtsp://cam1/ ! m.sink_0  m.src_0 ! ... \
+ *     rtspsrc location=rtsp://cam2/ ! m.sink_1  m.src_1 ! ...
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gstthroughputmux.h"
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
+GST_DEBUG_CATEGORY_STATIC (gst_throughput_mux_debug);
+#define GST_CAT_DEFAULT gst_throughput_mux_debug
+
+#define DEFAULT_STDERR                  FALSE
+#define DEFAULT_SILENT                  TRUE
+#define DEFAULT_POST_MESSAGES           TRUE
+#define DEFAULT_INTERVAL                1000
+#define DEFAULT_MAX_STREAMS             512
+#define DEFAULT_CLOCK_SOURCE            GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM
+
+enum
+{
+  PROP_0,
+  PROP_LAST_MESSAGE,
+  PROP_STDERR,
+  PROP_SILENT,
+  PROP_POST_MESSAGES,
+  PROP_INTERVAL,
+  PROP_STATS,
+  PROP_MAX_STREAMS,
+  PROP_CLOCK_SOURCE
+};
+
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_throughput_mux_debug, "throughputmux", 0, "throughputmux element");
+#define gst_throughput_mux_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstThroughputMux, gst_throughput_mux,
+    GST_TYPE_ELEMENT, _do_init);
+
+static void gst_throughput_mux_finalize (GObject * object);
+static void gst_throughput_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_throughput_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static GstPad *gst_throughput_mux_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
+static void gst_throughput_mux_release_pad (GstElement * element,
+    GstPad * pad);
+static GstStateChangeReturn gst_throughput_mux_change_state (GstElement *
+    element, GstStateChange transition);
+static gboolean gst_throughput_mux_set_clock (GstElement * element,
+    GstClock * clock);
+
+static GstFlowReturn gst_throughput_mux_chain (GstPad * pad,
+    GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_throughput_mux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
+static gboolean gst_throughput_mux_sink_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static GstIterator *gst_throughput_mux_iterate_internal_links (GstPad * pad,
+    GstObject * parent);
+static GstStructure *gst_throughput_mux_report (GstObject * object,
+    GstClockTime now);
+
+static GParamSpec *pspec_last_message = NULL;
+
+static void
+gst_throughput_mux_finalize (GObject * object)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (object);
+
+  g_free (mux->last_message);
+  if (mux->stats)
+    gst_structure_free (mux->stats);
+  g_free (mux->slots_memory);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_throughput_mux_class_init (GstThroughputMuxClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gstelement_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_throughput_mux_set_property;
+  gobject_class->get_property = gst_throughput_mux_get_property;
+  gobject_class->finalize = gst_throughput_mux_finalize;
+
+  pspec_last_message = g_param_spec_string ("last-message", "last-message",
+      "last-message", NULL, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (gobject_class, PROP_LAST_MESSAGE,
+      pspec_last_message);
+  g_object_class_install_property (gobject_class, PROP_STDERR,
+      g_param_spec_boolean ("stderr", "stderr",
+          "Also print measurements to stderr", DEFAULT_STDERR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SILENT,
+      g_param_spec_boolean ("silent", "silent",
+          "Don't format measurements into last-message (implied false by stderr)",
+          DEFAULT_SILENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post Messages",
+          "Post an element message with the stats of every interval",
+          DEFAULT_POST_MESSAGES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_INTERVAL,
+      g_param_spec_uint ("interval", "Report-Interval",
+          "Interval in Milliseconds between two measurements", 1, G_MAXUINT, DEFAULT_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Measurements of all streams in the last completed interval",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MAX_STREAMS,
+      g_param_spec_uint ("max-streams", "Max Streams",
+          "Number of streams to allocate counters for with the first pad",
+          1, G_MAXUINT16, DEFAULT_MAX_STREAMS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CLOCK_SOURCE,
+      g_param_spec_enum ("clock-source", "Clock Source",
+          "Where the times of the measurements are taken from",
+          GST_TYPE_THROUGHPUT_CLOCK_SOURCE, DEFAULT_CLOCK_SOURCE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "Throughput Mux",
+      "Generic",
+      "Measure the throughput of many streams at once",
+      "Peter Körner <peter@mazdermind.de>");
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+
+  gstelement_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_request_new_pad);
+  gstelement_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_release_pad);
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_change_state);
+  gstelement_class->set_clock = GST_DEBUG_FUNCPTR (gst_throughput_mux_set_clock);
+}
+
+static void
+gst_throughput_mux_init (GstThroughputMux * mux)
+{
+  mux->stderr = DEFAULT_STDERR;
+  mux->silent = DEFAULT_SILENT;
+  mux->post_messages = DEFAULT_POST_MESSAGES;
+  mux->clock_source = DEFAULT_CLOCK_SOURCE;
+  mux->last_message = NULL;
+  mux->stats = NULL;
+  mux->interval = DEFAULT_INTERVAL;
+  mux->group = NULL;
+  mux->started = FALSE;
+  mux->measure_clock = NULL;
+  mux->last_report = GST_CLOCK_TIME_NONE;
+  mux->max_streams = DEFAULT_MAX_STREAMS;
+  mux->slots_memory = NULL;
+  mux->slots = NULL;
+  mux->n_slots = 0;
+}
+
+/* called with the object lock held; the slots are never reallocated, so the
+ * streaming threads can keep using their stream without the lock */
+static gboolean
+gst_throughput_mux_alloc_slots (GstThroughputMux * mux)
+{
+  if (mux->slots)
+    return TRUE;
+
+  mux->slots_memory = g_try_malloc0 ((gsize) mux->max_streams *
+      sizeof (GstThroughputMuxSlot) + 63);
+  if (!mux->slots_memory)
+    return FALSE;
+
+  mux->slots = (GstThroughputMuxSlot *)
+      GST_ROUND_UP_64 ((guintptr) mux->slots_memory);
+
+  return TRUE;
+}
+
+static GstPad *
+gst_throughput_mux_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (element);
+  GstThroughputMuxStream *stream;
+  GstPad *sinkpad, *srcpad;
+  gchar *pad_name;
+  guint index = G_MAXUINT;
+
+  if (templ->direction != GST_PAD_SINK)
+    return NULL;
+
+  GST_OBJECT_LOCK (mux);
+  if (!gst_throughput_mux_alloc_slots (mux)) {
+    GST_OBJECT_UNLOCK (mux);
+    GST_ELEMENT_ERROR (mux, RESOURCE, NO_SPACE_LEFT, (NULL),
+        ("could not allocate counters for %u streams", mux->max_streams));
+    return NULL;
+  }
+
+  if (name && sscanf (name, "sink_%u", &index) == 1) {
+    if (index >= mux->max_streams || mux->slots[index].stream.active) {
+      GST_OBJECT_UNLOCK (mux);
+      GST_WARNING_OBJECT (mux, "pad %s is not available", name);
+      return NULL;
+    }
+  } else {
+    for (index = 0; index < mux->max_streams; index++)
+      if (!mux->slots[index].stream.active)
+        break;
+    if (index == mux->max_streams) {
+      GST_OBJECT_UNLOCK (mux);
+      GST_WARNING_OBJECT (mux, "all %u streams are in use", mux->max_streams);
+      return NULL;
+    }
+  }
+
+  /* reserved until the pads are added, a released slot is reused */
+  stream = &mux->slots[index].stream;
+  memset (stream, 0, sizeof (*stream));
+  gst_throughput_meter_init (&stream->meter);
+  stream->active = TRUE;
+  mux->n_slots = MAX (mux->n_slots, index + 1);
+  GST_OBJECT_UNLOCK (mux);
+
+  pad_name = g_strdup_printf ("sink_%u", index);
+  sinkpad = gst_pad_new_from_template (templ, pad_name);
+  g_free (pad_name);
+  pad_name = g_strdup_printf ("src_%u", index);
+  srcpad = gst_pad_new_from_static_template (&srctemplate, pad_name);
+  g_free (pad_name);
+
+  gst_pad_set_element_private (sinkpad, stream);
+  gst_pad_set_element_private (srcpad, stream);
+
+  gst_pad_set_chain_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_chain));
+  gst_pad_set_chain_list_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_chain_list));
+  gst_pad_set_event_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_sink_event));
+  gst_pad_set_iterate_internal_links_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_iterate_internal_links));
+  gst_pad_set_iterate_internal_links_function (srcpad,
+      GST_DEBUG_FUNCPTR (gst_throughput_mux_iterate_internal_links));
+
+  /* queries and upstream events go through the default handlers, which
+   * forward them along the internal link */
+  GST_PAD_SET_PROXY_CAPS (sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION (sinkpad);
+  GST_PAD_SET_PROXY_SCHEDULING (sinkpad);
+  GST_PAD_SET_PROXY_CAPS (srcpad);
+  GST_PAD_SET_PROXY_ALLOCATION (srcpad);
+  GST_PAD_SET_PROXY_SCHEDULING (srcpad);
+
+  GST_OBJECT_LOCK (mux);
+  stream->sinkpad = sinkpad;
+  stream->srcpad = srcpad;
+  GST_OBJECT_UNLOCK (mux);
+
+  GST_DEBUG_OBJECT (mux, "adding stream %u", index);
+
+  gst_element_add_pad (element, srcpad);
+  gst_element_add_pad (element, sinkpad);
+
+  return sinkpad;
+}
+
+static void
+gst_throughput_mux_release_pad (GstElement * element, GstPad * pad)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (element);
+  GstThroughputMuxStream *stream = gst_pad_get_element_private (pad);
+  GstPad *srcpad;
+
+  GST_DEBUG_OBJECT (mux, "releasing %" GST_PTR_FORMAT, pad);
+
+  /* no longer reported from here on */
+  GST_OBJECT_LOCK (mux);
+  stream->active = FALSE;
+  srcpad = stream->srcpad;
+  GST_OBJECT_UNLOCK (mux);
+
+  /* deactivating waits for a chain function still running on the stream */
+  gst_pad_set_active (pad, FALSE);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_element_remove_pad (element, srcpad);
+  gst_element_remove_pad (element, pad);
+
+  GST_OBJECT_LOCK (mux);
+  stream->sinkpad = stream->srcpad = NULL;
+  GST_OBJECT_UNLOCK (mux);
+}
+
+static GstIterator *
+gst_throughput_mux_iterate_internal_links (GstPad * pad, GstObject * parent)
+{
+  GstThroughputMuxStream *stream = gst_pad_get_element_private (pad);
+  GstIterator *it;
+  GstPad *other;
+  GValue val = G_VALUE_INIT;
+
+  GST_OBJECT_LOCK (parent);
+  other = GST_PAD_IS_SINK (pad) ? stream->srcpad : stream->sinkpad;
+  if (other)
+    gst_object_ref (other);
+  GST_OBJECT_UNLOCK (parent);
+
+  if (!other)
+    return NULL;
+
+  g_value_init (&val, GST_TYPE_PAD);
+  g_value_take_object (&val, other);
+  it = gst_iterator_new_single (GST_TYPE_PAD, &val);
+  g_value_unset (&val);
+
+  return it;
+}
+
+static GstFlowReturn
+gst_throughput_mux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstThroughputMuxStream *stream = gst_pad_get_element_private (pad);
+
+  gst_throughput_meter_count_buffers (&stream->meter, buf, buf, 1,
+      gst_buffer_get_size (buf));
+
+  return gst_pad_push (stream->srcpad, buf);
+}
+
+static GstFlowReturn
+gst_throughput_mux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstThroughputMuxStream *stream = gst_pad_get_element_private (pad);
+  gsize size = 0;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  if (len > 0) {
+    for (i = 0; i < len; i++)
+      size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+    gst_throughput_meter_count_buffers (&stream->meter,
+        gst_buffer_list_get (list, 0), gst_buffer_list_get (list, len - 1),
+        len, size);
+  }
+
+  return gst_pad_push_list (stream->srcpad, list);
+}
+
+static gboolean
+gst_throughput_mux_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstThroughputMuxStream *stream = gst_pad_get_element_private (pad);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:{
+      GstThroughputStreamInfo info;
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      gst_throughput_stream_info_from_caps (&info, caps);
+
+      GST_OBJECT_LOCK (parent);
+      stream->meter.info = info;
+      GST_OBJECT_UNLOCK (parent);
+      break;
+    }
+    case GST_EVENT_SEGMENT:
+      gst_throughput_meter_discont (&stream->meter);
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+/* called with the object lock held, returns the stats of the interval that
+ * just ended or NULL on the very first tick */
+static GstStructure *
+gst_throughput_mux_report_unlocked (GstThroughputMux * mux, GstClockTime now)
+{
+  GstThroughputMuxStream *stream;
+  GstThroughputMeasurement measurement;
+  GstStructure *stats, *stream_stats;
+  GValue streams = G_VALUE_INIT, value = G_VALUE_INIT;
+  gdouble buffers_per_second, bytes_per_second, value_double;
+  gdouble slowest_buffers_per_second = 0.0;
+  const gchar *slowest = NULL;
+  guint i, n_streams = 0;
+  gboolean first = !GST_CLOCK_TIME_IS_VALID (mux->last_report) ||
+      now <= mux->last_report;
+
+  g_value_init (&streams, GST_TYPE_ARRAY);
+  buffers_per_second = bytes_per_second = 0.0;
+
+  /* the only place that walks all streams, once per interval */
+  for (i = 0; i < mux->n_slots; i++) {
+    stream = &mux->slots[i].stream;
+    if (!stream->active || !stream->sinkpad)
+      continue;
+
+    gst_throughput_meter_snapshot (&stream->meter, now, &measurement);
+    stream_stats = first ? NULL : gst_throughput_meter_stats (&stream->meter,
+        &measurement, GST_OBJECT_NAME (stream->sinkpad));
+    stream->meter.last = measurement;
+    if (!stream_stats)
+      continue;
+
+    gst_structure_get_double (stream_stats, "buffers-per-second",
+        &value_double);
+    buffers_per_second += value_double;
+    if (!slowest || value_double < slowest_buffers_per_second) {
+      slowest = GST_OBJECT_NAME (stream->sinkpad);
+      slowest_buffers_per_second = value_double;
+    }
+    gst_structure_get_double (stream_stats, "bytes-per-second",
+        &value_double);
+    bytes_per_second += value_double;
+
+    g_value_init (&value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&value, stream_stats);
+    gst_value_array_append_and_take_value (&streams, &value);
+    n_streams++;
+  }
+
+  if (first || n_streams == 0) {
+    mux->last_report = now;
+    g_value_unset (&streams);
+    return NULL;
+  }
+
+  stats = gst_structure_new ("throughputmux",
+      "timestamp", G_TYPE_UINT64, now,
+      "interval", G_TYPE_UINT64, now - mux->last_report,
+      "active-streams", G_TYPE_UINT, n_streams,
+      "buffers-per-second", G_TYPE_DOUBLE, buffers_per_second,
+      "bytes-per-second", G_TYPE_DOUBLE, bytes_per_second,
+      "bits-per-second", G_TYPE_DOUBLE, bytes_per_second * 8,
+      "slowest-stream", G_TYPE_STRING, slowest,
+      "slowest-buffers-per-second", G_TYPE_DOUBLE,
+      slowest_buffers_per_second, NULL);
+  gst_structure_take_value (stats, "streams", &streams);
+
+  mux->last_report = now;
+
+  return stats;
+}
+
+static gchar *
+gst_throughput_mux_format_message (const GstStructure * stats)
+{
+  gdouble buffers_per_second, bytes_per_second, slowest_buffers_per_second;
+  guint n_streams;
+
+  gst_structure_get_uint (stats, "active-streams", &n_streams);
+  gst_structure_get_double (stats, "buffers-per-second", &buffers_per_second);
+  gst_structure_get_double (stats, "bytes-per-second", &bytes_per_second);
+  gst_structure_get_double (stats, "slowest-buffers-per-second",
+      &slowest_buffers_per_second);
+
+  return g_strdup_printf (
+    "Transfering %.0f Buffers/s at %.2f MBit/s in %u streams, slowest %s at %.0f Buffers/s",
+    buffers_per_second,
+    bytes_per_second / 1024 / 1024 * 8,
+    n_streams,
+    gst_structure_get_string (stats, "slowest-stream"),
+    slowest_buffers_per_second
+  );
+}
+
+/* called on the shared tick of the registry group, returns a copy of the
+ * new stats for the group's combined report */
+static GstStructure *
+gst_throughput_mux_report (GstObject * object, GstClockTime now)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (object);
+  GstStructure *stats, *result = NULL;
+  GstMessage *message = NULL;
+  gboolean new_message = FALSE;
+
+  /* the tick only paces the reports for the direct time sources */
+  if (mux->clock_source != GST_THROUGHPUT_CLOCK_SOURCE_SYSTEM &&
+      mux->clock_source != GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE)
+    now = gst_timing_time_source_get (&mux->time_source);
+
+  GST_OBJECT_LOCK (mux);
+  stats = gst_throughput_mux_report_unlocked (mux, now);
+  if (stats) {
+    if (mux->post_messages)
+      message = gst_message_new_element (GST_OBJECT_CAST (mux),
+          gst_structure_copy (stats));
+
+    if (!mux->silent || mux->stderr) {
+      g_free (mux->last_message);
+      mux->last_message = gst_throughput_mux_format_message (stats);
+      new_message = TRUE;
+    }
+
+    if (mux->stats)
+      gst_structure_free (mux->stats);
+    mux->stats = stats;
+    result = gst_structure_copy (stats);
+  }
+  GST_OBJECT_UNLOCK (mux);
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT_CAST (mux), message);
+
+  if (new_message) {
+    g_object_notify_by_pspec ((GObject *) mux, pspec_last_message);
+    if(mux->stderr)
+      g_message("(%s) %s", GST_ELEMENT_NAME(mux), mux->last_message);
+  }
+
+  return result;
+}
+
+/* moves the reports to the registry group of clock, or stops them for
+ * NULL; an interval never spans two clocks */
+static void
+gst_throughput_mux_use_clock (GstThroughputMux * mux, GstClock * clock)
+{
+  GstTimingGroup *group;
+  guint interval;
+
+  GST_OBJECT_LOCK (mux);
+  group = mux->group;
+  mux->group = NULL;
+  GST_OBJECT_UNLOCK (mux);
+
+  if (group)
+    gst_timing_registry_leave (group, GST_OBJECT_CAST (mux));
+
+  GST_OBJECT_LOCK (mux);
+  gst_object_replace ((GstObject **) & mux->measure_clock,
+      (GstObject *) clock);
+  mux->last_report = GST_CLOCK_TIME_NONE;
+  interval = mux->interval;
+  GST_OBJECT_UNLOCK (mux);
+
+  if (!clock)
+    return;
+
+  group = gst_timing_registry_join (GST_OBJECT_CAST (mux),
+      gst_throughput_mux_report, clock, interval);
+
+  GST_OBJECT_LOCK (mux);
+  mux->group = group;
+  GST_OBJECT_UNLOCK (mux);
+}
+
+static gboolean
+gst_throughput_mux_set_clock (GstElement * element, GstClock * clock)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (element);
+  gboolean changed;
+
+  GST_OBJECT_LOCK (mux);
+  changed = mux->started &&
+      mux->clock_source == GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE &&
+      mux->measure_clock != clock;
+  GST_OBJECT_UNLOCK (mux);
+
+  if (changed) {
+    GST_DEBUG_OBJECT (mux, "reporting on %" GST_PTR_FORMAT, clock);
+    gst_throughput_mux_use_clock (mux, clock);
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->set_clock (element, clock);
+}
+
+static void
+gst_throughput_mux_start (GstThroughputMux * mux)
+{
+  GstThroughputMuxStream *stream;
+  GstClock *clock;
+  guint i;
+
+  GST_OBJECT_LOCK (mux);
+  for (i = 0; i < mux->n_slots; i++) {
+    stream = &mux->slots[i].stream;
+    if (!stream->active)
+      continue;
+    gst_throughput_meter_init (&stream->meter);
+  }
+  mux->started = TRUE;
+  GST_OBJECT_UNLOCK (mux);
+
+  gst_throughput_clock_source_init (GST_OBJECT_CAST (mux), mux->clock_source,
+      &mux->time_source);
+
+  if (mux->clock_source == GST_THROUGHPUT_CLOCK_SOURCE_PIPELINE)
+    clock = gst_element_get_clock (GST_ELEMENT_CAST (mux));
+  else
+    clock = gst_system_clock_obtain ();
+
+  /* without a pipeline clock yet, set_clock starts the reports */
+  gst_throughput_mux_use_clock (mux, clock);
+  if (clock)
+    gst_object_unref (clock);
+}
+
+static void
+gst_throughput_mux_stop (GstThroughputMux * mux)
+{
+  GST_OBJECT_LOCK (mux);
+  mux->started = FALSE;
+  GST_OBJECT_UNLOCK (mux);
+
+  gst_throughput_mux_use_clock (mux, NULL);
+
+  GST_OBJECT_LOCK (mux);
+  g_free (mux->last_message);
+  mux->last_message = NULL;
+  if (mux->stats)
+    gst_structure_free (mux->stats);
+  mux->stats = NULL;
+  GST_OBJECT_UNLOCK (mux);
+}
+
+static GstStateChangeReturn
+gst_throughput_mux_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_throughput_mux_start (mux);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_throughput_mux_stop (mux);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_throughput_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (object);
+
+  switch (prop_id) {
+    case PROP_STDERR:
+      mux->stderr = g_value_get_boolean (value);
+      break;
+    case PROP_SILENT:
+      mux->silent = g_value_get_boolean (value);
+      break;
+    case PROP_POST_MESSAGES:
+      mux->post_messages = g_value_get_boolean (value);
+      break;
+    case PROP_INTERVAL:{
+      GstClock *clock = NULL;
+
+      GST_OBJECT_LOCK (mux);
+      mux->interval = g_value_get_uint (value);
+      if (mux->group && mux->measure_clock)
+        clock = gst_object_ref (mux->measure_clock);
+      GST_OBJECT_UNLOCK (mux);
+
+      /* while running, move over to the group of the new interval */
+      if (clock) {
+        gst_throughput_mux_use_clock (mux, clock);
+        gst_object_unref (clock);
+      }
+      break;
+    }
+    case PROP_MAX_STREAMS:
+      GST_OBJECT_LOCK (mux);
+      if (mux->slots)
+        g_warning ("%s: max-streams can only be changed before the first pad "
+            "is requested", GST_ELEMENT_NAME (mux));
+      else
+        mux->max_streams = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_CLOCK_SOURCE:
+      mux->clock_source = g_value_get_enum (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_throughput_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstThroughputMux *mux = GST_THROUGHPUT_MUX (object);
+
+  switch (prop_id) {
+    case PROP_LAST_MESSAGE:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_string (value, mux->last_message);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_STDERR:
+      g_value_set_boolean (value, mux->stderr);
+      break;
+    case PROP_SILENT:
+      g_value_set_boolean (value, mux->silent);
+      break;
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, mux->post_messages);
+      break;
+    case PROP_INTERVAL:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_uint (value, mux->interval);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_STATS:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_boxed (value, mux->stats);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_MAX_STREAMS:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_uint (value, mux->max_streams);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_CLOCK_SOURCE:
+      g_value_set_enum (value, mux->clock_source);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
@@ -0,0 +1,104 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+
+#ifndef __GST_THROUGHPUT_MUX_H__
+#define __GST_THROUGHPUT_MUX_H__
+
+
+#include <gst/gst.h>
+
+#include "gstthroughput.h"
+#include "gstthroughputmeter.h"
+
+G_BEGIN_DECLS
+
+
+#define GST_TYPE_THROUGHPUT_MUX \
+  (gst_throughput_mux_get_type())
+#define GST_THROUGHPUT_MUX(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_THROUGHPUT_MUX,GstThroughputMux))
+#define GST_THROUGHPUT_MUX_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_THROUGHPUT_MUX,GstThroughputMuxClass))
+#define GST_IS_THROUGHPUT_MUX(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_THROUGHPUT_MUX))
+#define GST_IS_THROUGHPUT_MUX_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_THROUGHPUT_MUX))
+
+typedef struct _GstThroughputMux GstThroughputMux;
+typedef struct _GstThroughputMuxClass GstThroughputMuxClass;
+
+/* One measured stream. The meter counters are written by the stream's own
+ * streaming thread only, everything else is set up under the object lock
+ * when the pads are requested and released. */
+typedef struct {
+  GstThroughputMeter meter;
+
+  GstPad         *sinkpad;
+  GstPad         *srcpad;
+  gboolean       active;
+} GstThroughputMuxStream;
+
+/* every stream on cache lines of its own, so the streaming threads of two
+ * streams never write to the same line */
+typedef union {
+  GstThroughputMuxStream stream;
+  guint8         padding[GST_ROUND_UP_64 (sizeof (GstThroughputMuxStream))];
+} GstThroughputMuxSlot;
+
+/**
+ * GstThroughputMux:
+ *
+ * Opaque #GstThroughputMux data structure
+ */
+struct _GstThroughputMux {
+  GstElement     element;
+
+  /*< private >*/
+  gboolean       stderr;
+  gboolean       silent;
+  gboolean       post_messages;
+  GstThroughputClockSource clock_source;
+  gchar          *last_message;
+  GstStructure   *stats;
+
+  /* report interval in ms and the registry group that ticks the reports,
+   * protected by the object lock */
+  guint          interval;
+  GstTimingGroup *group;
+  gboolean       started;
+  GstClock       *measure_clock;
+  /* the other clock sources, set up in start */
+  GstTimingTimeSource time_source;
+  GstClockTime   last_report;
+
+  /* max_streams slots, 64 byte aligned inside slots_memory and allocated
+   * with the first pad; n_slots is one past the highest slot ever used */
+  guint          max_streams;
+  gpointer       slots_memory;
+  GstThroughputMuxSlot *slots;
+  guint          n_slots;
+};
+
+struct _GstThroughputMuxClass {
+  GstElementClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_throughput_mux_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_THROUGHPUT_MUX_H__ */
@@ -0,0 +1,309 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/**
+ * SECTION:gstthroughputprobe
+ * @short_description: Throughput measurement on an existing pad
+ *
+ * Measures the throughput of a pad of a running pipeline with a pad probe,
+ * without relinking anything or renegotiating caps, so measurement points
+ * can be added and removed at any time:
+ *
+ * |[
+ * GstThroughputProbe *probe;
+ *
+ * probe = gst_throughput_probe_attach (encoder_src, 1000);
+ * ...
+ * gst_throughput_probe_detach (probe);
+ * ]|
+ *
+ * The buffers and buffer lists passing the pad are counted with the same
+ * meter the throughput element uses. Every interval the stats are posted as
+ * an element message named "throughput" with the same fields as the
+ * element's basic stats, by the element the pad belongs to and with the
+ * probe as its source, and are available from
+ * gst_throughput_probe_get_stats(). The intervals of a probe start when it
+ * is attached and are not aligned with those of the elements, and a probe is
+ * never part of the combined "throughput-report" message.
+ *
+ * Link with libgstthroughputprobe-1.0 and include
+ * <gst/timing/gstthroughputprobe.h>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstthroughputprobe.h"
+#include "gstthroughputmeter.h"
+#include "gsttimingreporter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_throughput_probe_debug);
+#define GST_CAT_DEFAULT gst_throughput_probe_debug
+
+struct _GstThroughputProbe
+{
+  GstObject object;
+
+  /* set in attach, never changed */
+  GstPad *pad;
+  gulong probe_id;
+
+  /* written by the streaming thread of the pad only */
+  GstThroughputMeter meter;
+
+  /* protected by the object lock; a reporter of its own, as the registry
+   * of the elements is in the plugin and not in this library */
+  GstTimingReporter reporter;
+  GstStructure *stats;
+};
+
+struct _GstThroughputProbeClass
+{
+  GstObjectClass parent_class;
+};
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_throughput_probe_debug, "throughputprobe", 0, "throughput pad probe");
+#define gst_throughput_probe_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstThroughputProbe, gst_throughput_probe,
+    GST_TYPE_OBJECT, _do_init);
+
+static void gst_throughput_probe_report (GstObject * object,
+    GstClockTime now);
+
+static void
+gst_throughput_probe_finalize (GObject * object)
+{
+  GstThroughputProbe *probe = GST_THROUGHPUT_PROBE (object);
+
+  if (probe->stats)
+    gst_structure_free (probe->stats);
+  gst_object_unref (probe->pad);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_throughput_probe_class_init (GstThroughputProbeClass * klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = gst_throughput_probe_finalize;
+}
+
+static void
+gst_throughput_probe_init (GstThroughputProbe * probe)
+{
+  gst_throughput_meter_init (&probe->meter);
+  probe->stats = NULL;
+}
+
+static GstPadProbeReturn
+gst_throughput_probe_callback (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstThroughputProbe *probe = user_data;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    gst_throughput_meter_count_buffers (&probe->meter, buf, buf, 1,
+        gst_buffer_get_size (buf));
+  } else if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    gsize size = 0;
+    guint i, len;
+
+    len = gst_buffer_list_length (list);
+    if (len == 0)
+      return GST_PAD_PROBE_OK;
+    for (i = 0; i < len; i++)
+      size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+    gst_throughput_meter_count_buffers (&probe->meter,
+        gst_buffer_list_get (list, 0), gst_buffer_list_get (list, len - 1),
+        len, size);
+  } else if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      GstThroughputStreamInfo stream_info;
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      gst_throughput_stream_info_from_caps (&stream_info, caps);
+
+      GST_OBJECT_LOCK (probe);
+      probe->meter.info = stream_info;
+      GST_OBJECT_UNLOCK (probe);
+    } else if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+      gst_throughput_meter_discont (&probe->meter);
+    }
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+gst_throughput_probe_report (GstObject * object, GstClockTime now)
+{
+  GstThroughputProbe *probe = GST_THROUGHPUT_PROBE (object);
+  GstThroughputMeasurement measurement;
+  GstStructure *stats;
+  GstElement *parent;
+
+  GST_OBJECT_LOCK (probe);
+  gst_throughput_meter_snapshot (&probe->meter, now, &measurement);
+  stats = gst_throughput_meter_stats (&probe->meter, &measurement,
+      "throughput");
+  probe->meter.last = measurement;
+  if (stats) {
+    if (probe->stats)
+      gst_structure_free (probe->stats);
+    probe->stats = gst_structure_copy (stats);
+  }
+  GST_OBJECT_UNLOCK (probe);
+
+  if (!stats)
+    return;
+
+  parent = gst_pad_get_parent_element (probe->pad);
+  if (parent) {
+    gst_element_post_message (parent,
+        gst_message_new_element (GST_OBJECT_CAST (probe), stats));
+    gst_object_unref (parent);
+  } else {
+    gst_structure_free (stats);
+  }
+}
+
+/**
+ * gst_throughput_probe_attach:
+ * @pad: the pad to measure
+ * @interval: milliseconds between two reports
+ *
+ * Starts measuring the buffers passing @pad, with the reports scheduled on
+ * the system clock.
+ *
+ * Returns: (transfer full): the new measurement point, to be passed to
+ *     gst_throughput_probe_detach()
+ */
+GstThroughputProbe *
+gst_throughput_probe_attach (GstPad * pad, guint interval)
+{
+  GstThroughputProbe *probe;
+  GstClock *clock;
+
+  clock = gst_system_clock_obtain ();
+  probe = gst_throughput_probe_attach_with_clock (pad, interval, clock);
+  gst_object_unref (clock);
+
+  return probe;
+}
+
+/**
+ * gst_throughput_probe_attach_with_clock:
+ * @pad: the pad to measure
+ * @interval: milliseconds between two reports
+ * @clock: the clock to schedule the reports on
+ *
+ * Like gst_throughput_probe_attach(), with the reports scheduled on @clock,
+ * e.g. the pipeline clock.
+ *
+ * Returns: (transfer full): the new measurement point, to be passed to
+ *     gst_throughput_probe_detach()
+ */
+GstThroughputProbe *
+gst_throughput_probe_attach_with_clock (GstPad * pad, guint interval,
+    GstClock * clock)
+{
+  GstThroughputProbe *probe;
+  GstCaps *caps;
+  gchar *name;
+
+  g_return_val_if_fail (GST_IS_PAD (pad), NULL);
+  g_return_val_if_fail (interval > 0, NULL);
+  g_return_val_if_fail (GST_IS_CLOCK (clock), NULL);
+
+  name = gst_object_get_path_string (GST_OBJECT_CAST (pad));
+  probe = g_object_new (GST_TYPE_THROUGHPUT_PROBE, "name", name, NULL);
+  gst_object_ref_sink (probe);
+  g_free (name);
+
+  probe->pad = gst_object_ref (pad);
+
+  /* the caps of a running stream are not sent again */
+  caps = gst_pad_get_current_caps (pad);
+  if (caps) {
+    gst_throughput_stream_info_from_caps (&probe->meter.info, caps);
+    gst_caps_unref (caps);
+  }
+
+  gst_timing_reporter_init (&probe->reporter, gst_throughput_probe_report,
+      interval);
+  gst_timing_reporter_start (&probe->reporter, GST_OBJECT_CAST (probe),
+      clock);
+
+  probe->probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      gst_throughput_probe_callback, gst_object_ref (probe),
+      (GDestroyNotify) gst_object_unref);
+
+  GST_DEBUG_OBJECT (probe, "attached, reporting every %u ms", interval);
+
+  return probe;
+}
+
+/**
+ * gst_throughput_probe_detach:
+ * @probe: (transfer full): a measurement point
+ *
+ * Stops measuring and releases @probe. A report that is already running may
+ * still complete.
+ */
+void
+gst_throughput_probe_detach (GstThroughputProbe * probe)
+{
+  g_return_if_fail (GST_IS_THROUGHPUT_PROBE (probe));
+
+  gst_pad_remove_probe (probe->pad, probe->probe_id);
+  gst_timing_reporter_stop (&probe->reporter, GST_OBJECT_CAST (probe));
+
+  GST_DEBUG_OBJECT (probe, "detached");
+
+  gst_object_unref (probe);
+}
+
+/**
+ * gst_throughput_probe_get_stats:
+ * @probe: a measurement point
+ *
+ * Returns: (transfer full) (nullable): the stats of the last completed
+ *     interval, or %NULL if there was none yet
+ */
+GstStructure *
+gst_throughput_probe_get_stats (GstThroughputProbe * probe)
+{
+  GstStructure *stats = NULL;
+
+  g_return_val_if_fail (GST_IS_THROUGHPUT_PROBE (probe), NULL);
+
+  GST_OBJECT_LOCK (probe);
+  if (probe->stats)
+    stats = gst_structure_copy (probe->stats);
+  GST_OBJECT_UNLOCK (probe);
+
+  return stats;
+}
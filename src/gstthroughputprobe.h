@@ -0,0 +1,58 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_THROUGHPUT_PROBE_H__
+#define __GST_THROUGHPUT_PROBE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_THROUGHPUT_PROBE \
+  (gst_throughput_probe_get_type())
+#define GST_THROUGHPUT_PROBE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_THROUGHPUT_PROBE,GstThroughputProbe))
+#define GST_IS_THROUGHPUT_PROBE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_THROUGHPUT_PROBE))
+
+/**
+ * GstThroughputProbe:
+ *
+ * Opaque measurement point installed on a pad with
+ * gst_throughput_probe_attach()
+ *
+ * Unlike the throughput element, a probe reports on a tick of its own that
+ * starts when it is attached: its intervals are not aligned with those of
+ * the elements or of other probes on the same clock, and its stats are not
+ * part of the combined "throughput-report" message of the pipeline. The
+ * probe lives in its own library, outside of the plugin that keeps the
+ * elements' registry.
+ */
+typedef struct _GstThroughputProbe GstThroughputProbe;
+typedef struct _GstThroughputProbeClass GstThroughputProbeClass;
+
+GType gst_throughput_probe_get_type (void);
+
+GstThroughputProbe * gst_throughput_probe_attach (GstPad * pad,
+    guint interval);
+GstThroughputProbe * gst_throughput_probe_attach_with_clock (GstPad * pad,
+    guint interval, GstClock * clock);
+void gst_throughput_probe_detach (GstThroughputProbe * probe);
+GstStructure * gst_throughput_probe_get_stats (GstThroughputProbe * probe);
+
+G_END_DECLS
+
+#endif /* __GST_THROUGHPUT_PROBE_H__ */
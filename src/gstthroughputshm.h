@@ -0,0 +1,92 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_THROUGHPUT_SHM_H__
+#define __GST_THROUGHPUT_SHM_H__
+
+/* Binary layout of the file every throughput element with a shm-dir maps
+ * into memory. It is read by tools/gst-throughput-top without GLib, so only
+ * plain C types are used here. Any change to the layout has to bump
+ * GST_THROUGHPUT_SHM_VERSION. */
+
+#include <stdint.h>
+#include <string.h>
+
+#define GST_THROUGHPUT_SHM_MAGIC        0x53505447u     /* "GTPS" */
+#define GST_THROUGHPUT_SHM_VERSION      1
+#define GST_THROUGHPUT_SHM_NAME_LEN     128
+#define GST_THROUGHPUT_SHM_SUFFIX       ".throughput"
+
+typedef struct _GstThroughputShm GstThroughputShm;
+
+struct _GstThroughputShm {
+  /* written once before the file is given its final name */
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;                /* sizeof (GstThroughputShm) of the writer */
+  uint32_t pid;
+  char     name[GST_THROUGHPUT_SHM_NAME_LEN];   /* object path */
+
+  /* seqlock, odd while the writer updates the fields below */
+  uint32_t seq;
+  uint32_t media_kind;          /* 0 other, 1 video, 2 audio */
+  uint64_t timestamp;           /* monotonic ns of the last report */
+  uint64_t interval;            /* ns covered by the rates */
+  uint64_t buffers;             /* totals since start */
+  uint64_t bytes;
+  uint64_t offsets;
+  double   nominal_rate;        /* frames or samples per second from caps */
+  double   buffers_per_second;
+  double   bytes_per_second;
+  double   offsets_per_second;
+};
+
+static inline void
+gst_throughput_shm_write_begin (GstThroughputShm * shm)
+{
+  __atomic_store_n (&shm->seq, shm->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+}
+
+static inline void
+gst_throughput_shm_write_end (GstThroughputShm * shm)
+{
+  __atomic_store_n (&shm->seq, shm->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* copies a consistent snapshot of @shm into @copy, returns 0 if the writer
+ * kept updating it (or died halfway through an update) */
+static inline int
+gst_throughput_shm_read (const GstThroughputShm * shm,
+    GstThroughputShm * copy)
+{
+  uint32_t seq;
+  int tries;
+
+  for (tries = 0; tries < 1000; tries++) {
+    seq = __atomic_load_n (&shm->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1)
+      continue;
+    memcpy (copy, shm, sizeof (*copy));
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    if (__atomic_load_n (&shm->seq, __ATOMIC_RELAXED) == seq)
+      return 1;
+  }
+
+  return 0;
+}
+
+#endif /* __GST_THROUGHPUT_SHM_H__ */
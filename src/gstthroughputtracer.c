@@ -0,0 +1,475 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/**
+ * SECTION:tracer-padthroughput
+ *
+ * Measures the same rates as the throughput element on every pad of every
+ * pipeline, or on the pads whose "element:pad" name matches a pattern,
+ * without modifying the pipeline. Buffers and buffer lists are counted when
+ * they are pushed by a source pad or pulled by a sink pad; ghost and proxy
+ * pads are skipped so data crossing a bin is only counted once.
+ *
+ * Every interval one record per active pad is logged to the GST_TRACER
+ * debug category, carrying the interval length and the buffers, bytes and
+ * offsets (frames or samples) transferred in it.
+ *
+ * |[
+ * GST_TRACERS="padthroughput(filter=x264*:src,interval=500)" GST_DEBUG=GST_TRACER:7 gst-launch-1.0 ...
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstthroughputtracer.h"
+#include "gstthroughputmeter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_throughput_tracer_debug);
+#define GST_CAT_DEFAULT gst_throughput_tracer_debug
+
+#define DEFAULT_INTERVAL                1000
+
+/* Lives in the qdata of its pad and in the list of the tracer, either can
+ * go first, so both are only known through weak refs. Freed once it is in
+ * neither, attached and listed are protected by pads_lock. */
+typedef struct
+{
+  gchar *name;
+  gboolean ignored;
+  GstThroughputMeter meter;
+  GWeakRef tracer;
+  GWeakRef pad;
+  gboolean attached;
+  gboolean listed;
+} GstThroughputTracerPad;
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_throughput_tracer_debug, "padthroughput", 0, "padthroughput tracer");
+#define gst_throughput_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstThroughputTracer, gst_throughput_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+/* Owner of the reporter. Every pending tick holds a reference on its owner;
+ * with the tracer itself as the owner it could never be finalized while
+ * reporting, so the ticks only get to the tracer through a weak ref. */
+struct _GstThroughputTracerTicker
+{
+  GstObject object;
+
+  GWeakRef tracer;
+  GstTimingReporter reporter;
+};
+
+typedef struct
+{
+  GstObjectClass parent_class;
+} GstThroughputTracerTickerClass;
+
+G_GNUC_INTERNAL GType gst_throughput_tracer_ticker_get_type (void);
+G_DEFINE_TYPE (GstThroughputTracerTicker, gst_throughput_tracer_ticker,
+    GST_TYPE_OBJECT);
+
+static GstTracerRecord *tr_throughput;
+static GQuark pad_quark;
+/* serializes the pads being freed with the tracer being finalized, which
+ * the weak ref alone cannot tell apart from a tracer that is gone */
+static GMutex pads_lock;
+
+static void
+gst_throughput_tracer_pad_free (GstThroughputTracerPad * tpad)
+{
+  g_weak_ref_clear (&tpad->tracer);
+  g_weak_ref_clear (&tpad->pad);
+  g_free (tpad->name);
+  g_slice_free (GstThroughputTracerPad, tpad);
+}
+
+/* destroy notify of the pad's qdata */
+static void
+gst_throughput_tracer_pad_detach (gpointer data)
+{
+  GstThroughputTracerPad *tpad = data;
+  GstThroughputTracer *tracer;
+  gboolean unused;
+
+  /* the pad is gone, stop reporting it */
+  g_mutex_lock (&pads_lock);
+  tracer = g_weak_ref_get (&tpad->tracer);
+  if (tracer && tpad->listed) {
+    GST_OBJECT_LOCK (tracer);
+    tracer->pads = g_list_remove (tracer->pads, tpad);
+    GST_OBJECT_UNLOCK (tracer);
+    tpad->listed = FALSE;
+  }
+  tpad->attached = FALSE;
+  unused = !tpad->listed;
+  g_mutex_unlock (&pads_lock);
+
+  /* can be the last ref, finalize takes pads_lock */
+  if (tracer)
+    gst_object_unref (tracer);
+
+  if (unused)
+    gst_throughput_tracer_pad_free (tpad);
+}
+
+static GstThroughputTracerPad *
+gst_throughput_tracer_get_pad (GstThroughputTracer * tracer, GstPad * pad)
+{
+  GstThroughputTracerPad *tpad, *other;
+  GstObject *parent;
+  GstCaps *caps;
+
+  tpad = g_object_get_qdata ((GObject *) pad, pad_quark);
+  if (G_LIKELY (tpad))
+    return tpad;
+
+  /* first buffer on this pad */
+  tpad = g_slice_new0 (GstThroughputTracerPad);
+  g_weak_ref_init (&tpad->tracer, tracer);
+  g_weak_ref_init (&tpad->pad, pad);
+  gst_throughput_meter_init (&tpad->meter);
+
+  parent = gst_pad_get_parent (pad);
+  tpad->name = g_strdup_printf ("%s:%s", parent ? GST_OBJECT_NAME (parent) :
+      "", GST_OBJECT_NAME (pad));
+  if (parent)
+    gst_object_unref (parent);
+
+  tpad->ignored = GST_IS_PROXY_PAD (pad) ||
+      (tracer->filter && !g_pattern_match_string (tracer->filter, tpad->name));
+
+  if ((caps = gst_pad_get_current_caps (pad))) {
+    gst_throughput_stream_info_from_caps (&tpad->meter.info, caps);
+    gst_caps_unref (caps);
+  }
+
+  /* e.g. a push and a pull_range racing for a new pad: the first one to
+   * get here wins and the other one uses its tpad */
+  g_mutex_lock (&pads_lock);
+  other = g_object_get_qdata ((GObject *) pad, pad_quark);
+  if (!other) {
+    tpad->attached = TRUE;
+    g_object_set_qdata_full ((GObject *) pad, pad_quark, tpad,
+        gst_throughput_tracer_pad_detach);
+    if (!tpad->ignored) {
+      tpad->listed = TRUE;
+      GST_OBJECT_LOCK (tracer);
+      tracer->pads = g_list_prepend (tracer->pads, tpad);
+      GST_OBJECT_UNLOCK (tracer);
+    }
+  }
+  g_mutex_unlock (&pads_lock);
+
+  if (other) {
+    gst_throughput_tracer_pad_free (tpad);
+    return other;
+  }
+
+  if (!tpad->ignored)
+    GST_DEBUG_OBJECT (tracer, "measuring %s", tpad->name);
+
+  return tpad;
+}
+
+static void
+do_push_buffer_pre (GstThroughputTracer * self, GstClockTime ts, GstPad * pad,
+    GstBuffer * buffer)
+{
+  GstThroughputTracerPad *tpad = gst_throughput_tracer_get_pad (self, pad);
+
+  if (tpad->ignored)
+    return;
+
+  gst_throughput_meter_count_buffers (&tpad->meter, buffer, buffer, 1,
+      gst_buffer_get_size (buffer));
+}
+
+static void
+do_push_buffer_list_pre (GstThroughputTracer * self, GstClockTime ts,
+    GstPad * pad, GstBufferList * list)
+{
+  GstThroughputTracerPad *tpad = gst_throughput_tracer_get_pad (self, pad);
+  gsize size = 0;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  if (tpad->ignored || len == 0)
+    return;
+
+  for (i = 0; i < len; i++)
+    size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+  gst_throughput_meter_count_buffers (&tpad->meter,
+      gst_buffer_list_get (list, 0), gst_buffer_list_get (list, len - 1),
+      len, size);
+}
+
+static void
+do_pull_range_post (GstThroughputTracer * self, GstClockTime ts, GstPad * pad,
+    GstBuffer * buffer, GstFlowReturn res)
+{
+  GstThroughputTracerPad *tpad;
+
+  if (res != GST_FLOW_OK || buffer == NULL)
+    return;
+
+  tpad = gst_throughput_tracer_get_pad (self, pad);
+  if (tpad->ignored)
+    return;
+
+  gst_throughput_meter_count_buffers (&tpad->meter, buffer, buffer, 1,
+      gst_buffer_get_size (buffer));
+}
+
+static void
+do_push_event_pre (GstThroughputTracer * self, GstClockTime ts, GstPad * pad,
+    GstEvent * event)
+{
+  GstThroughputTracerPad *tpad;
+  GstThroughputStreamInfo info;
+  GstCaps *caps;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS &&
+      GST_EVENT_TYPE (event) != GST_EVENT_SEGMENT)
+    return;
+
+  tpad = gst_throughput_tracer_get_pad (self, pad);
+  if (tpad->ignored)
+    return;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+    gst_throughput_meter_discont (&tpad->meter);
+    return;
+  }
+
+  gst_event_parse_caps (event, &caps);
+  gst_throughput_stream_info_from_caps (&info, caps);
+
+  GST_OBJECT_LOCK (self);
+  tpad->meter.info = info;
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_throughput_tracer_report (GstThroughputTracer * self, GstClockTime now)
+{
+  GstThroughputMeasurement measurement;
+  GstStructure *stats;
+  GList *walk;
+
+  GST_OBJECT_LOCK (self);
+  for (walk = self->pads; walk; walk = g_list_next (walk)) {
+    GstThroughputTracerPad *tpad = walk->data;
+    guint64 interval, buffers, bytes, offsets;
+
+    gst_throughput_meter_snapshot (&tpad->meter, now, &measurement);
+    stats = gst_throughput_meter_stats (&tpad->meter, &measurement,
+        "padthroughput");
+    tpad->meter.last = measurement;
+    if (!stats)
+      continue;
+
+    gst_structure_get (stats,
+        "interval", G_TYPE_UINT64, &interval,
+        "interval-buffers", G_TYPE_UINT64, &buffers,
+        "interval-bytes", G_TYPE_UINT64, &bytes,
+        "interval-offsets", G_TYPE_UINT64, &offsets, NULL);
+    gst_tracer_record_log (tr_throughput, tpad->name, interval, buffers, bytes,
+        offsets);
+
+    GST_INFO_OBJECT (self, "%s: %" GST_PTR_FORMAT, tpad->name, stats);
+    gst_structure_free (stats);
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_throughput_tracer_tick (GstObject * object, GstClockTime now)
+{
+  GstThroughputTracerTicker *ticker = (GstThroughputTracerTicker *) object;
+  GstThroughputTracer *self;
+
+  self = g_weak_ref_get (&ticker->tracer);
+  if (!self)
+    return;
+
+  gst_throughput_tracer_report (self, now);
+  gst_object_unref (self);
+}
+
+static void
+gst_throughput_tracer_ticker_finalize (GObject * object)
+{
+  GstThroughputTracerTicker *ticker = (GstThroughputTracerTicker *) object;
+
+  g_weak_ref_clear (&ticker->tracer);
+
+  G_OBJECT_CLASS (gst_throughput_tracer_ticker_parent_class)->finalize
+      (object);
+}
+
+static void
+gst_throughput_tracer_ticker_class_init (GstThroughputTracerTickerClass *
+    klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = gst_throughput_tracer_ticker_finalize;
+}
+
+static void
+gst_throughput_tracer_ticker_init (GstThroughputTracerTicker * ticker)
+{
+  g_weak_ref_init (&ticker->tracer, NULL);
+  gst_timing_reporter_init (&ticker->reporter, gst_throughput_tracer_tick,
+      DEFAULT_INTERVAL);
+}
+
+static void
+gst_throughput_tracer_constructed (GObject * object)
+{
+  GstThroughputTracer *self = GST_THROUGHPUT_TRACER (object);
+  GstStructure *params_struct = NULL;
+  gchar *params, *tmp;
+  const gchar *filter;
+  GstClock *clock;
+  guint interval;
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+
+  g_object_get (self, "params", &params, NULL);
+  if (params) {
+    tmp = g_strdup_printf ("padthroughput,%s", params);
+    params_struct = gst_structure_from_string (tmp, NULL);
+    g_free (tmp);
+    if (!params_struct)
+      GST_WARNING_OBJECT (self, "invalid params '%s'", params);
+    g_free (params);
+  }
+
+  if (params_struct) {
+    if ((filter = gst_structure_get_string (params_struct, "filter")))
+      self->filter = g_pattern_spec_new (filter);
+    if (gst_structure_get_uint (params_struct, "interval", &interval) &&
+        interval > 0)
+      self->ticker->reporter.interval = interval;
+    gst_structure_free (params_struct);
+  }
+
+  gst_tracing_register_hook (GST_TRACER (self), "pad-push-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (GST_TRACER (self), "pad-push-list-pre",
+      G_CALLBACK (do_push_buffer_list_pre));
+  gst_tracing_register_hook (GST_TRACER (self), "pad-pull-range-post",
+      G_CALLBACK (do_pull_range_post));
+  gst_tracing_register_hook (GST_TRACER (self), "pad-push-event-pre",
+      G_CALLBACK (do_push_event_pre));
+
+  clock = gst_system_clock_obtain ();
+  gst_timing_reporter_start (&self->ticker->reporter,
+      GST_OBJECT_CAST (self->ticker), clock);
+  gst_object_unref (clock);
+}
+
+static void
+gst_throughput_tracer_finalize (GObject * object)
+{
+  GstThroughputTracer *self = GST_THROUGHPUT_TRACER (object);
+  GList *walk, *pads = NULL;
+  GstPad *pad;
+
+  /* the pending tick goes away with the ticker */
+  gst_timing_reporter_stop (&self->ticker->reporter,
+      GST_OBJECT_CAST (self->ticker));
+  gst_object_unref (self->ticker);
+
+  if (self->filter)
+    g_pattern_spec_free (self->filter);
+
+  /* the pads that are still alive drop their measurements, the ones that
+   * were already detached are freed here */
+  g_mutex_lock (&pads_lock);
+  GST_OBJECT_LOCK (self);
+  for (walk = self->pads; walk; walk = g_list_next (walk)) {
+    GstThroughputTracerPad *tpad = walk->data;
+
+    tpad->listed = FALSE;
+    if (!tpad->attached)
+      gst_throughput_tracer_pad_free (tpad);
+    else if ((pad = g_weak_ref_get (&tpad->pad)))
+      pads = g_list_prepend (pads, pad);
+  }
+  g_list_free (self->pads);
+  self->pads = NULL;
+  GST_OBJECT_UNLOCK (self);
+  g_mutex_unlock (&pads_lock);
+
+  for (walk = pads; walk; walk = g_list_next (walk))
+    g_object_set_qdata ((GObject *) walk->data, pad_quark, NULL);
+  g_list_free_full (pads, gst_object_unref);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_throughput_tracer_class_init (GstThroughputTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->constructed = gst_throughput_tracer_constructed;
+  gobject_class->finalize = gst_throughput_tracer_finalize;
+
+  pad_quark = g_quark_from_static_string ("GstThroughputTracer.pad");
+
+  /* rates are left to the reader, which keeps every field an integer */
+  tr_throughput = gst_tracer_record_new ("padthroughput.class",
+      "pad", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "interval", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "length of the interval in ns",
+          NULL),
+      "buffers", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "buffers in the interval",
+          NULL),
+      "bytes", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "bytes in the interval",
+          NULL),
+      "offsets", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+          "frames or samples in the interval, by buffer offsets or else "
+          "derived from the caps",
+          NULL),
+      NULL);
+  GST_OBJECT_FLAG_SET (tr_throughput, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_throughput_tracer_init (GstThroughputTracer * self)
+{
+  self->filter = NULL;
+  self->pads = NULL;
+
+  self->ticker = g_object_new (gst_throughput_tracer_ticker_get_type (), NULL);
+  gst_object_ref_sink (self->ticker);
+  g_weak_ref_set (&self->ticker->tracer, self);
+}
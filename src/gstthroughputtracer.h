@@ -0,0 +1,71 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+
+#ifndef __GST_THROUGHPUT_TRACER_H__
+#define __GST_THROUGHPUT_TRACER_H__
+
+
+#include <gst/gst.h>
+
+#include "gsttimingreporter.h"
+
+G_BEGIN_DECLS
+
+
+#define GST_TYPE_THROUGHPUT_TRACER \
+  (gst_throughput_tracer_get_type())
+#define GST_THROUGHPUT_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_THROUGHPUT_TRACER,GstThroughputTracer))
+#define GST_THROUGHPUT_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_THROUGHPUT_TRACER,GstThroughputTracerClass))
+#define GST_IS_THROUGHPUT_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_THROUGHPUT_TRACER))
+#define GST_IS_THROUGHPUT_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_THROUGHPUT_TRACER))
+
+typedef struct _GstThroughputTracer GstThroughputTracer;
+typedef struct _GstThroughputTracerClass GstThroughputTracerClass;
+typedef struct _GstThroughputTracerTicker GstThroughputTracerTicker;
+
+/**
+ * GstThroughputTracer:
+ *
+ * Opaque #GstThroughputTracer data structure
+ */
+struct _GstThroughputTracer {
+  GstTracer      parent;
+
+  /*< private >*/
+  GPatternSpec   *filter;
+  /* runs the reporter, so its ticks do not keep the tracer alive */
+  GstThroughputTracerTicker *ticker;
+
+  /* GstThroughputTracerPad of every pad seen so far that matched the
+   * filter, protected by the object lock and only changed while also
+   * holding the pads lock of the tracer's pads */
+  GList          *pads;
+};
+
+struct _GstThroughputTracerClass {
+  GstTracerClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_throughput_tracer_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_THROUGHPUT_TRACER_H__ */
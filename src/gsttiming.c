@@ -22,12 +22,26 @@
 #endif
 
 #include "gstthroughput.h"
+#include "gstthroughputmux.h"
+#include "gstsyntheticload.h"
+#include "gstlatencystamp.h"
+#include "gstlatencyprobe.h"
+#include "gstthroughputtracer.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
   gst_element_register (plugin, "throughput", GST_RANK_NONE,
       GST_TYPE_THROUGHPUT);
+  gst_element_register (plugin, "throughputmux", GST_RANK_NONE,
+      GST_TYPE_THROUGHPUT_MUX);
+  gst_element_register (plugin, "syntheticload", GST_RANK_NONE,
+      GST_TYPE_SYNTHETIC_LOAD);
+  gst_element_register (plugin, "latencystamp", GST_RANK_NONE,
+      GST_TYPE_LATENCY_STAMP);
+  gst_element_register (plugin, "latencyprobe", GST_RANK_NONE,
+      GST_TYPE_LATENCY_PROBE);
+  gst_tracer_register (plugin, "padthroughput", GST_TYPE_THROUGHPUT_TRACER);
 
   return TRUE;
 }
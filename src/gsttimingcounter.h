@@ -0,0 +1,56 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_TIMING_COUNTER_H__
+#define __GST_TIMING_COUNTER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Measurement counters have a single writer (the streaming thread) and are
+ * read concurrently by the reporter, so relaxed loads and stores are enough
+ * and no read-modify-write instruction is needed on the hot path. */
+#define GST_TIMING_COUNTER_GET(c) \
+  __atomic_load_n (&(c), __ATOMIC_RELAXED)
+#define GST_TIMING_COUNTER_SET(c,v) \
+  __atomic_store_n (&(c), (v), __ATOMIC_RELAXED)
+#define GST_TIMING_COUNTER_ADD(c,v) \
+  __atomic_store_n (&(c), (c) + (v), __ATOMIC_RELAXED)
+
+/* Used by the reporter to read and restart a value the writer only ever
+ * raises or lowers, such as the maximum of an interval. The writer has to
+ * use GST_TIMING_COUNTER_RAISE or _LOWER on such a value, a plain store
+ * could overwrite the restart with a stale value. */
+#define GST_TIMING_COUNTER_TAKE(c,v) \
+  __atomic_exchange_n (&(c), (v), __ATOMIC_RELAXED)
+
+/* Only pay for a compare-and-swap when the value actually changes, which
+ * for a minimum or maximum is rare once the stream settled. */
+#define GST_TIMING_COUNTER_LOWER(c,v) G_STMT_START {                        \
+  __typeof__ (c) _cur = __atomic_load_n (&(c), __ATOMIC_RELAXED);          \
+  while ((v) < _cur && !__atomic_compare_exchange_n (&(c), &_cur, (v),     \
+          TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED));                      \
+} G_STMT_END
+#define GST_TIMING_COUNTER_RAISE(c,v) G_STMT_START {                        \
+  __typeof__ (c) _cur = __atomic_load_n (&(c), __ATOMIC_RELAXED);          \
+  while ((v) > _cur && !__atomic_compare_exchange_n (&(c), &_cur, (v),     \
+          TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED));                      \
+} G_STMT_END
+
+G_END_DECLS
+
+#endif /* __GST_TIMING_COUNTER_H__ */
@@ -0,0 +1,216 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gsttiminghistogram.h"
+
+/* largest value that falls into the bucket at idx */
+static guint64
+gst_timing_histogram_bucket_upper (guint idx)
+{
+  guint shift;
+  guint64 mantissa;
+
+  if (idx < GST_TIMING_HISTOGRAM_SUB_COUNT)
+    return idx;
+
+  shift = idx / (GST_TIMING_HISTOGRAM_SUB_COUNT / 2) - 1;
+  mantissa = idx - shift * (GST_TIMING_HISTOGRAM_SUB_COUNT / 2);
+
+  if (shift + GST_TIMING_HISTOGRAM_SUB_BITS >= 64)
+    return G_MAXUINT64;
+
+  return ((mantissa + 1) << shift) - 1;
+}
+
+/* smallest value that falls into the bucket at idx */
+static guint64
+gst_timing_histogram_bucket_lower (guint idx)
+{
+  if (idx == 0)
+    return 0;
+
+  return gst_timing_histogram_bucket_upper (idx - 1) + 1;
+}
+
+/* The writer's min/max are not ordered against the reporter taking them,
+ * so an interval can have counts without a min/max, or a min/max of a value
+ * that is only counted in the next one. Falls back to the bounds of the
+ * lowest and highest non-empty bucket then. */
+static void
+gst_timing_histogram_fix_range (GstTimingHistogram * histogram)
+{
+  guint i;
+
+  if (histogram->count == 0) {
+    histogram->min = G_MAXUINT64;
+    histogram->max = 0;
+    return;
+  }
+  if (histogram->min <= histogram->max)
+    return;
+
+  for (i = 0; i < GST_TIMING_HISTOGRAM_N_BUCKETS; i++) {
+    if (histogram->counts[i]) {
+      histogram->min = gst_timing_histogram_bucket_lower (i);
+      break;
+    }
+  }
+  for (i = GST_TIMING_HISTOGRAM_N_BUCKETS; i > 0; i--) {
+    if (histogram->counts[i - 1]) {
+      histogram->max = gst_timing_histogram_bucket_upper (i - 1);
+      break;
+    }
+  }
+}
+
+void
+gst_timing_histogram_reset (GstTimingHistogram * histogram)
+{
+  memset (histogram->counts, 0, sizeof (histogram->counts));
+  histogram->count = 0;
+  histogram->sum = 0;
+  histogram->min = G_MAXUINT64;
+  histogram->max = 0;
+}
+
+/* Returns the highest value that is equivalent (same bucket) to the value
+ * below which percentile percent of all recorded values are, clamped to the
+ * recorded range if there is one. 0 if nothing was recorded. */
+guint64
+gst_timing_histogram_percentile (const GstTimingHistogram * histogram,
+    gdouble percentile)
+{
+  guint64 target, seen = 0;
+  guint i;
+
+  if (histogram->count == 0)
+    return 0;
+
+  target = (guint64) (percentile / 100.0 * histogram->count + 0.5);
+  target = CLAMP (target, 1, histogram->count);
+
+  for (i = 0; i < GST_TIMING_HISTOGRAM_N_BUCKETS; i++) {
+    seen += histogram->counts[i];
+    if (seen < target)
+      continue;
+    if (histogram->min > histogram->max)
+      return gst_timing_histogram_bucket_upper (i);
+    return CLAMP (gst_timing_histogram_bucket_upper (i), histogram->min,
+        histogram->max);
+  }
+
+  return histogram->max;
+}
+
+/* adds <prefix>-count, -min, -mean, -p50, -p90, -p99, -p999 and -max */
+void
+gst_timing_histogram_add_to_structure (const GstTimingHistogram * histogram,
+    GstStructure * structure, const gchar * prefix)
+{
+  static const struct
+  {
+    const gchar *name;
+    gdouble percentile;
+  } percentiles[] = {
+    {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}
+  };
+  gchar *name;
+  guint i;
+
+  name = g_strconcat (prefix, "-count", NULL);
+  gst_structure_set (structure, name, G_TYPE_UINT64, histogram->count, NULL);
+  g_free (name);
+
+  name = g_strconcat (prefix, "-min", NULL);
+  gst_structure_set (structure, name, G_TYPE_UINT64,
+      histogram->count && histogram->min <= histogram->max ?
+      histogram->min : 0, NULL);
+  g_free (name);
+
+  name = g_strconcat (prefix, "-mean", NULL);
+  gst_structure_set (structure, name, G_TYPE_DOUBLE,
+      histogram->count ? (gdouble) histogram->sum / histogram->count : 0.0,
+      NULL);
+  g_free (name);
+
+  for (i = 0; i < G_N_ELEMENTS (percentiles); i++) {
+    name = g_strconcat (prefix, "-", percentiles[i].name, NULL);
+    gst_structure_set (structure, name, G_TYPE_UINT64,
+        gst_timing_histogram_percentile (histogram, percentiles[i].percentile),
+        NULL);
+    g_free (name);
+  }
+
+  name = g_strconcat (prefix, "-max", NULL);
+  gst_structure_set (structure, name, G_TYPE_UINT64, histogram->max, NULL);
+  g_free (name);
+}
+
+void
+gst_timing_histogram_view_init (GstTimingHistogramView * view)
+{
+  gst_timing_histogram_reset (&view->last);
+  gst_timing_histogram_reset (&view->interval);
+  gst_timing_histogram_reset (&view->total);
+}
+
+void
+gst_timing_histogram_view_reset_total (GstTimingHistogramView * view)
+{
+  gst_timing_histogram_reset (&view->total);
+}
+
+/* Called by the reporter once per interval. Only reads the live bucket
+ * counts and restarts its min/max, the writer keeps running. */
+void
+gst_timing_histogram_view_collect (GstTimingHistogramView * view,
+    GstTimingHistogram * live)
+{
+  GstTimingHistogram *last = &view->last;
+  GstTimingHistogram *interval = &view->interval;
+  GstTimingHistogram *total = &view->total;
+  guint64 value;
+  guint i;
+
+  for (i = 0; i < GST_TIMING_HISTOGRAM_N_BUCKETS; i++) {
+    value = GST_TIMING_COUNTER_GET (live->counts[i]);
+    interval->counts[i] = value - last->counts[i];
+    total->counts[i] += interval->counts[i];
+    last->counts[i] = value;
+  }
+
+  value = GST_TIMING_COUNTER_GET (live->count);
+  interval->count = value - last->count;
+  total->count += interval->count;
+  last->count = value;
+
+  value = GST_TIMING_COUNTER_GET (live->sum);
+  interval->sum = value - last->sum;
+  total->sum += interval->sum;
+  last->sum = value;
+
+  interval->min = GST_TIMING_COUNTER_TAKE (live->min, G_MAXUINT64);
+  interval->max = GST_TIMING_COUNTER_TAKE (live->max, 0);
+  gst_timing_histogram_fix_range (interval);
+  total->min = MIN (total->min, interval->min);
+  total->max = MAX (total->max, interval->max);
+}
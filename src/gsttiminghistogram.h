@@ -0,0 +1,101 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_TIMING_HISTOGRAM_H__
+#define __GST_TIMING_HISTOGRAM_H__
+
+#include <gst/gst.h>
+
+#include "gsttimingcounter.h"
+
+G_BEGIN_DECLS
+
+/* Log-bucketed histogram in the spirit of HdrHistogram: values below
+ * 2^SUB_BITS get a bucket each, above that every power of two is split into
+ * 2^(SUB_BITS-1) linear buckets, so a bucket is never wider than 1/16th of
+ * the values it holds. All 64 bit values fit into a fixed 976 buckets. */
+#define GST_TIMING_HISTOGRAM_SUB_BITS   5
+#define GST_TIMING_HISTOGRAM_SUB_COUNT  (1 << GST_TIMING_HISTOGRAM_SUB_BITS)
+#define GST_TIMING_HISTOGRAM_N_BUCKETS \
+  ((64 - GST_TIMING_HISTOGRAM_SUB_BITS + 2) * (GST_TIMING_HISTOGRAM_SUB_COUNT / 2))
+
+typedef struct _GstTimingHistogram GstTimingHistogram;
+typedef struct _GstTimingHistogramView GstTimingHistogramView;
+
+/* Written by exactly one thread with gst_timing_histogram_record(), which
+ * never allocates or locks. min and max only cover the values recorded
+ * since the reporter last collected them. */
+struct _GstTimingHistogram {
+  guint64        counts[GST_TIMING_HISTOGRAM_N_BUCKETS];
+  guint64        count;
+  guint64        sum;
+  guint64        min;
+  guint64        max;
+};
+
+/* Reporter side of a live histogram: what was recorded in the last interval
+ * and since the last reset, both derived from the live counts so the writer
+ * never has to be stopped. */
+struct _GstTimingHistogramView {
+  GstTimingHistogram last;
+  GstTimingHistogram interval;
+  GstTimingHistogram total;
+};
+
+static inline guint
+gst_timing_histogram_index (guint64 value)
+{
+  guint msb, shift;
+
+  if (value < GST_TIMING_HISTOGRAM_SUB_COUNT)
+    return (guint) value;
+
+  msb = 63 - __builtin_clzll (value);
+  shift = msb - GST_TIMING_HISTOGRAM_SUB_BITS + 1;
+
+  return shift * (GST_TIMING_HISTOGRAM_SUB_COUNT / 2) + (guint) (value >> shift);
+}
+
+static inline void
+gst_timing_histogram_record (GstTimingHistogram * histogram, guint64 value)
+{
+  guint idx = gst_timing_histogram_index (value);
+
+  GST_TIMING_COUNTER_ADD (histogram->counts[idx], 1);
+  GST_TIMING_COUNTER_ADD (histogram->count, 1);
+  GST_TIMING_COUNTER_ADD (histogram->sum, value);
+  /* the reporter restarts them concurrently */
+  GST_TIMING_COUNTER_LOWER (histogram->min, value);
+  GST_TIMING_COUNTER_RAISE (histogram->max, value);
+}
+
+G_GNUC_INTERNAL void gst_timing_histogram_reset (GstTimingHistogram * histogram);
+G_GNUC_INTERNAL guint64 gst_timing_histogram_percentile (
+    const GstTimingHistogram * histogram, gdouble percentile);
+G_GNUC_INTERNAL void gst_timing_histogram_add_to_structure (
+    const GstTimingHistogram * histogram, GstStructure * structure,
+    const gchar * prefix);
+
+G_GNUC_INTERNAL void gst_timing_histogram_view_init (
+    GstTimingHistogramView * view);
+G_GNUC_INTERNAL void gst_timing_histogram_view_reset_total (
+    GstTimingHistogramView * view);
+G_GNUC_INTERNAL void gst_timing_histogram_view_collect (
+    GstTimingHistogramView * view, GstTimingHistogram * live);
+
+G_END_DECLS
+
+#endif /* __GST_TIMING_HISTOGRAM_H__ */
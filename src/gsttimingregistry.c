@@ -0,0 +1,280 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* Ticks the reports of all elements that share a clock and an interval
+ * together. Every group runs a single GstTimingReporter; on its tick the
+ * members are reported one after the other with the same clock time, so
+ * their intervals are aligned and e.g. the stages of one pipeline can be
+ * compared interval by interval. Groups can span pipelines, as all of them
+ * share the system clock by default, but each combined report only holds
+ * the members of one top-level bin and is posted inside of it, so no
+ * pipeline sees the measurements of another. Joining and leaving only
+ * happens when an
+ * element starts, stops or changes clock or interval; the streaming threads
+ * never touch the registry. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gsttimingregistry.h"
+#include "gsttimingreporter.h"
+
+#define GST_TYPE_TIMING_GROUP \
+  (gst_timing_group_get_type())
+#define GST_TIMING_GROUP(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_TIMING_GROUP,GstTimingGroup))
+
+typedef struct
+{
+  gint refcount;
+  GstObject *object;
+  GstTimingRegistryFunc func;
+  /* the top-level bin at join; only compared, never dereferenced */
+  gpointer top;
+  /* cleared under the registry lock on leave, a tick that already took the
+   * member skips it */
+  gint active;
+} GstTimingMember;
+
+/* clock and interval never change, the members are protected by the
+ * registry lock */
+struct _GstTimingGroup
+{
+  GstObject object;
+
+  GstClock *clock;
+  guint interval;
+  GstTimingReporter reporter;
+  GArray *members;
+};
+
+typedef struct
+{
+  GstObjectClass parent_class;
+} GstTimingGroupClass;
+
+G_GNUC_INTERNAL GType gst_timing_group_get_type (void);
+G_DEFINE_TYPE (GstTimingGroup, gst_timing_group, GST_TYPE_OBJECT);
+
+static GMutex registry_lock;
+static GList *registry_groups = NULL;
+
+static GstTimingMember *
+gst_timing_member_ref (GstTimingMember * member)
+{
+  g_atomic_int_inc (&member->refcount);
+  return member;
+}
+
+static void
+gst_timing_member_unref (GstTimingMember * member)
+{
+  if (g_atomic_int_dec_and_test (&member->refcount))
+    g_free (member);
+}
+
+static void
+gst_timing_group_finalize (GObject * object)
+{
+  GstTimingGroup *group = GST_TIMING_GROUP (object);
+
+  gst_object_unref (group->clock);
+  g_ptr_array_unref (group->members);
+
+  G_OBJECT_CLASS (gst_timing_group_parent_class)->finalize (object);
+}
+
+static void
+gst_timing_group_class_init (GstTimingGroupClass * klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = gst_timing_group_finalize;
+}
+
+static void
+gst_timing_group_init (GstTimingGroup * group)
+{
+  group->members =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_timing_member_unref);
+}
+
+/* the outermost parent of object, usually its pipeline, only to tell the
+ * bins apart: no reference is kept */
+static gpointer
+gst_timing_top_level (GstObject * object)
+{
+  GstObject *top = gst_object_ref (object), *parent;
+
+  while ((parent = gst_object_get_parent (top))) {
+    gst_object_unref (top);
+    top = parent;
+  }
+  gst_object_unref (top);
+
+  return top;
+}
+
+/* posts the stats of all members from the same top-level bin as first
+ * together as one "throughput-report" message, if there are more than one;
+ * takes the stats and clears them */
+static void
+gst_timing_group_post (GstTimingGroup * group, GstClockTime now,
+    GstTimingMember ** members, GstStructure ** stats, guint first,
+    guint n_members)
+{
+  GstStructure *report;
+  GValue measurements = G_VALUE_INIT, value = G_VALUE_INIT;
+  guint i, n_measurements = 0;
+
+  g_value_init (&measurements, GST_TYPE_ARRAY);
+  for (i = first; i < n_members; i++) {
+    if (!stats[i] || members[i]->top != members[first]->top)
+      continue;
+
+    gst_structure_set (stats[i], "element", G_TYPE_STRING,
+        GST_OBJECT_NAME (members[i]->object), NULL);
+    g_value_init (&value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&value, stats[i]);
+    gst_value_array_append_and_take_value (&measurements, &value);
+    stats[i] = NULL;
+    n_measurements++;
+  }
+
+  if (n_measurements > 1 && GST_IS_ELEMENT (members[first]->object)) {
+    report = gst_structure_new ("throughput-report",
+        "timestamp", G_TYPE_UINT64, now,
+        "interval", G_TYPE_UINT64, group->interval * GST_MSECOND, NULL);
+    gst_structure_take_value (report, "measurements", &measurements);
+    gst_element_post_message (GST_ELEMENT_CAST (members[first]->object),
+        gst_message_new_element (members[first]->object, report));
+  } else {
+    g_value_unset (&measurements);
+  }
+}
+
+/* reports every member at the same now; the measurements of each top-level
+ * bin with more than one of them are also posted together by its member
+ * that joined first */
+static void
+gst_timing_group_tick (GstObject * object, GstClockTime now)
+{
+  GstTimingGroup *group = GST_TIMING_GROUP (object);
+  GstTimingMember **members;
+  GstStructure **stats;
+  guint i, n_members;
+
+  g_mutex_lock (&registry_lock);
+  n_members = group->members->len;
+  members = g_new (GstTimingMember *, MAX (n_members, 1));
+  for (i = 0; i < n_members; i++) {
+    members[i] = gst_timing_member_ref (g_ptr_array_index (group->members, i));
+    gst_object_ref (members[i]->object);
+  }
+  g_mutex_unlock (&registry_lock);
+
+  stats = g_new0 (GstStructure *, MAX (n_members, 1));
+  for (i = 0; i < n_members; i++) {
+    /* left since the snapshot, its reports have stopped */
+    if (!g_atomic_int_get (&members[i]->active))
+      continue;
+    stats[i] = members[i]->func (members[i]->object, now);
+  }
+
+  for (i = 0; i < n_members; i++) {
+    if (stats[i])
+      gst_timing_group_post (group, now, members, stats, i, n_members);
+  }
+
+  for (i = 0; i < n_members; i++) {
+    gst_object_unref (members[i]->object);
+    gst_timing_member_unref (members[i]);
+  }
+  g_free (stats);
+  g_free (members);
+}
+
+GstTimingGroup *
+gst_timing_registry_join (GstObject * member, GstTimingRegistryFunc func,
+    GstClock * clock, guint interval)
+{
+  GstTimingMember *m;
+  GstTimingGroup *group = NULL;
+  GList *l;
+
+  m = g_new (GstTimingMember, 1);
+  m->refcount = 1;
+  m->object = member;
+  m->func = func;
+  /* members join when they start, inside of the bin they run in */
+  m->top = gst_timing_top_level (member);
+  m->active = TRUE;
+
+  g_mutex_lock (&registry_lock);
+  for (l = registry_groups; l; l = l->next) {
+    GstTimingGroup *g = l->data;
+
+    if (g->clock == clock && g->interval == interval) {
+      group = g;
+      break;
+    }
+  }
+
+  if (!group) {
+    group = g_object_new (GST_TYPE_TIMING_GROUP, NULL);
+    gst_object_ref_sink (group);
+    group->clock = gst_object_ref (clock);
+    group->interval = interval;
+    gst_timing_reporter_init (&group->reporter, gst_timing_group_tick,
+        interval);
+    registry_groups = g_list_prepend (registry_groups, group);
+
+    gst_timing_reporter_start (&group->reporter, GST_OBJECT_CAST (group),
+        clock);
+  }
+
+  g_ptr_array_add (group->members, m);
+  g_mutex_unlock (&registry_lock);
+
+  /* owned by the member until it leaves */
+  return gst_object_ref (group);
+}
+
+void
+gst_timing_registry_leave (GstTimingGroup * group, GstObject * member)
+{
+  guint i;
+
+  g_mutex_lock (&registry_lock);
+  for (i = 0; i < group->members->len; i++) {
+    GstTimingMember *m = g_ptr_array_index (group->members, i);
+
+    if (m->object == member) {
+      g_atomic_int_set (&m->active, FALSE);
+      g_ptr_array_remove_index (group->members, i);
+      break;
+    }
+  }
+
+  /* the last member takes the group and its tick with it */
+  if (group->members->len == 0) {
+    registry_groups = g_list_remove (registry_groups, group);
+    gst_timing_reporter_stop (&group->reporter, GST_OBJECT_CAST (group));
+    gst_object_unref (group);
+  }
+  g_mutex_unlock (&registry_lock);
+
+  gst_object_unref (group);
+}
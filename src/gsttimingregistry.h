@@ -0,0 +1,51 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_TIMING_REGISTRY_H__
+#define __GST_TIMING_REGISTRY_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstTimingGroup GstTimingGroup;
+
+/**
+ * GstTimingRegistryFunc:
+ * @member: the object that joined the registry
+ * @now: time of the group's clock at the shared tick
+ *
+ * Reports the interval of @member that ends at @now. Called for all members
+ * of a group one after the other from the async thread of its clock,
+ * without any lock held. Returns a copy of the stats of the interval to be
+ * owned by the caller, or NULL if there are none yet.
+ */
+typedef GstStructure * (*GstTimingRegistryFunc) (GstObject * member,
+    GstClockTime now);
+
+/* The process wide registry of reporting elements. All members with the same
+ * clock and interval form a group that is ticked once per interval, so their
+ * intervals end at the same clock time. Combined reports are only made of
+ * members with the same top-level bin, as it was when they joined. After
+ * leave, only a report that is already running may still complete. */
+G_GNUC_INTERNAL GstTimingGroup * gst_timing_registry_join (GstObject * member,
+    GstTimingRegistryFunc func, GstClock * clock, guint interval);
+G_GNUC_INTERNAL void gst_timing_registry_leave (GstTimingGroup * group,
+    GstObject * member);
+
+G_END_DECLS
+
+#endif /* __GST_TIMING_REGISTRY_H__ */
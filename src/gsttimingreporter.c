@@ -0,0 +1,158 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* Shared interval machinery of the timing elements: a chain of single-shot
+ * clock ids that calls back into the owning object once per interval, so
+ * evaluating and publishing measurements never happens on the streaming
+ * thread. Every pending tick holds a reference on the owner, which keeps it
+ * alive until the tick has run or was unscheduled. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gsttimingreporter.h"
+
+typedef struct
+{
+  GstObject *owner;
+  GstTimingReporter *reporter;
+} GstTimingReporterTick;
+
+static gboolean gst_timing_reporter_tick (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data);
+
+static void
+gst_timing_reporter_tick_free (gpointer data)
+{
+  GstTimingReporterTick *tick = data;
+
+  gst_object_unref (tick->owner);
+  g_slice_free (GstTimingReporterTick, tick);
+}
+
+static void
+gst_timing_reporter_schedule (GstTimingReporter * reporter, GstObject * owner,
+    GstClockID id)
+{
+  GstTimingReporterTick *tick;
+
+  tick = g_slice_new (GstTimingReporterTick);
+  tick->owner = gst_object_ref (owner);
+  tick->reporter = reporter;
+
+  /* an id that was unscheduled by stop in the meantime still owns the tick
+   * and frees it with the id; only a refused time or a clock that cannot
+   * wait returns before the id took it */
+  switch (gst_clock_id_wait_async (id, gst_timing_reporter_tick, tick,
+          gst_timing_reporter_tick_free)) {
+    case GST_CLOCK_BADTIME:
+    case GST_CLOCK_UNSUPPORTED:
+      gst_timing_reporter_tick_free (tick);
+      break;
+    default:
+      break;
+  }
+}
+
+static gboolean
+gst_timing_reporter_tick (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstTimingReporterTick *tick = user_data;
+  GstTimingReporter *reporter = tick->reporter;
+  GstObject *owner = tick->owner;
+  GstClockTime now, interval, next_time;
+  GstClockID next;
+
+  GST_OBJECT_LOCK (owner);
+  if (reporter->id != id) {
+    /* stopped while this tick was being dispatched */
+    GST_OBJECT_UNLOCK (owner);
+    return TRUE;
+  }
+
+  now = gst_clock_get_time (clock);
+  interval = reporter->interval * GST_MSECOND;
+
+  /* schedule relative to the previous tick so reports do not drift, but
+   * never in the past if we fell behind */
+  next_time = time + interval;
+  if (!GST_CLOCK_TIME_IS_VALID (time) || next_time < now)
+    next_time = now + interval;
+
+  next = gst_clock_new_single_shot_id (clock, next_time);
+  gst_clock_id_unref (reporter->id);
+  reporter->id = gst_clock_id_ref (next);
+  GST_OBJECT_UNLOCK (owner);
+
+  reporter->func (owner, now);
+
+  gst_timing_reporter_schedule (reporter, owner, next);
+  gst_clock_id_unref (next);
+
+  return TRUE;
+}
+
+void
+gst_timing_reporter_init (GstTimingReporter * reporter,
+    GstTimingReportFunc func, guint interval)
+{
+  reporter->func = func;
+  reporter->interval = interval;
+  reporter->clock = NULL;
+  reporter->id = NULL;
+}
+
+void
+gst_timing_reporter_start (GstTimingReporter * reporter, GstObject * owner,
+    GstClock * clock)
+{
+  GstClockID id;
+
+  g_return_if_fail (reporter->id == NULL);
+
+  GST_OBJECT_LOCK (owner);
+  gst_object_replace ((GstObject **) & reporter->clock, (GstObject *) clock);
+  id = gst_clock_new_single_shot_id (clock,
+      gst_clock_get_time (clock) + reporter->interval * GST_MSECOND);
+  reporter->id = gst_clock_id_ref (id);
+  GST_OBJECT_UNLOCK (owner);
+
+  gst_timing_reporter_schedule (reporter, owner, id);
+  gst_clock_id_unref (id);
+}
+
+void
+gst_timing_reporter_stop (GstTimingReporter * reporter, GstObject * owner)
+{
+  GstClockID id;
+  GstClock *clock;
+
+  GST_OBJECT_LOCK (owner);
+  id = reporter->id;
+  reporter->id = NULL;
+  clock = reporter->clock;
+  reporter->clock = NULL;
+  GST_OBJECT_UNLOCK (owner);
+
+  if (id) {
+    gst_clock_id_unschedule (id);
+    gst_clock_id_unref (id);
+  }
+  if (clock)
+    gst_object_unref (clock);
+}
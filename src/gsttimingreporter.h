@@ -0,0 +1,56 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_TIMING_REPORTER_H__
+#define __GST_TIMING_REPORTER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstTimingReporter GstTimingReporter;
+
+/**
+ * GstTimingReportFunc:
+ * @owner: the object the reporter belongs to
+ * @now: time of the reporter's clock when the tick fired
+ *
+ * Called once per interval from the async thread of the clock, without the
+ * object lock of @owner held.
+ */
+typedef void (*GstTimingReportFunc) (GstObject * owner, GstClockTime now);
+
+/* Calls func every interval milliseconds off the streaming thread. Embedded
+ * in the owning object, all fields are protected by its object lock. */
+struct _GstTimingReporter {
+  GstTimingReportFunc func;
+  guint          interval;
+
+  /*< private >*/
+  GstClock       *clock;
+  GstClockID     id;
+};
+
+G_GNUC_INTERNAL void gst_timing_reporter_init (GstTimingReporter * reporter,
+    GstTimingReportFunc func, guint interval);
+G_GNUC_INTERNAL void gst_timing_reporter_start (GstTimingReporter * reporter,
+    GstObject * owner, GstClock * clock);
+G_GNUC_INTERNAL void gst_timing_reporter_stop (GstTimingReporter * reporter,
+    GstObject * owner);
+
+G_END_DECLS
+
+#endif /* __GST_TIMING_REPORTER_H__ */
@@ -0,0 +1,125 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gsttimingtimesource.h"
+
+#ifdef GST_TIMING_HAVE_TSC
+#  include <cpuid.h>
+#endif
+
+void
+gst_timing_time_source_init_monotonic (GstTimingTimeSource * source)
+{
+  source->tsc = FALSE;
+  source->clock_id = CLOCK_MONOTONIC;
+}
+
+/* only as fine as the scheduler tick (1-4ms), but never leaves user space
+ * and costs barely more than a memory read. Falls back to CLOCK_MONOTONIC
+ * and returns FALSE where it does not exist. */
+gboolean
+gst_timing_time_source_init_monotonic_coarse (GstTimingTimeSource * source)
+{
+  gst_timing_time_source_init_monotonic (source);
+
+#ifdef CLOCK_MONOTONIC_COARSE
+  source->clock_id = CLOCK_MONOTONIC_COARSE;
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+#ifdef GST_TIMING_HAVE_TSC
+static gdouble tsc_ns_per_tick = 0.0;
+
+/* the TSC only makes a clock when it runs at a constant rate in all
+ * P- and C-states, which CPUs announce as "invariant TSC" */
+static gboolean
+gst_timing_tsc_is_invariant (void)
+{
+  guint eax, ebx, ecx, edx;
+
+  if (__get_cpuid_max (0x80000000, NULL) < 0x80000007)
+    return FALSE;
+  __cpuid (0x80000007, eax, ebx, ecx, edx);
+
+  return (edx & (1 << 8)) != 0;
+}
+
+/* measures the TSC against CLOCK_MONOTONIC once per process */
+static gpointer
+gst_timing_tsc_calibrate (gpointer data)
+{
+  struct timespec ts;
+  GstClockTime start, stop;
+  guint64 tsc_start, tsc_stop;
+
+  if (!gst_timing_tsc_is_invariant ())
+    return NULL;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  tsc_start = __rdtsc ();
+  start = GST_TIMESPEC_TO_TIME (ts);
+
+  g_usleep (20000);
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  tsc_stop = __rdtsc ();
+  stop = GST_TIMESPEC_TO_TIME (ts);
+
+  if (tsc_stop <= tsc_start)
+    return NULL;
+
+  tsc_ns_per_tick = (gdouble) (stop - start) / (gdouble) (tsc_stop - tsc_start);
+  GST_INFO ("TSC runs at %.3f MHz", 1000.0 / tsc_ns_per_tick);
+
+  return GINT_TO_POINTER (TRUE);
+}
+#endif
+
+/* Uses the TSC, calibrated against CLOCK_MONOTONIC, and shares its time
+ * base. Falls back to CLOCK_MONOTONIC and returns FALSE where there is no
+ * invariant TSC. */
+gboolean
+gst_timing_time_source_init_tsc (GstTimingTimeSource * source)
+{
+#ifdef GST_TIMING_HAVE_TSC
+  static GOnce calibrated = G_ONCE_INIT;
+  struct timespec ts;
+#endif
+
+  gst_timing_time_source_init_monotonic (source);
+
+#ifdef GST_TIMING_HAVE_TSC
+  if (!g_once (&calibrated, gst_timing_tsc_calibrate, NULL))
+    return FALSE;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  source->tsc_base = __rdtsc ();
+  source->ns_base = GST_TIMESPEC_TO_TIME (ts);
+  source->ns_per_tick = tsc_ns_per_tick;
+  source->tsc = TRUE;
+
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
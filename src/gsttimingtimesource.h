@@ -0,0 +1,68 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+#ifndef __GST_TIMING_TIME_SOURCE_H__
+#define __GST_TIMING_TIME_SOURCE_H__
+
+#include <time.h>
+
+#include <gst/gst.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define GST_TIMING_HAVE_TSC 1
+#endif
+
+G_BEGIN_DECLS
+
+typedef struct _GstTimingTimeSource GstTimingTimeSource;
+
+/* A wall-clock read that costs a few ns and touches no shared state: a
+ * clock_gettime() that the vDSO serves from user space, or the TSC scaled
+ * to ns. Resolved once, then read from any thread without locking. */
+struct _GstTimingTimeSource {
+  gboolean       tsc;
+  clockid_t      clock_id;
+  guint64        tsc_base;
+  GstClockTime   ns_base;
+  gdouble        ns_per_tick;
+};
+
+static inline GstClockTime
+gst_timing_time_source_get (const GstTimingTimeSource * source)
+{
+  struct timespec ts;
+
+#ifdef GST_TIMING_HAVE_TSC
+  if (source->tsc)
+    return source->ns_base + (GstClockTimeDiff)
+        ((gint64) (__rdtsc () - source->tsc_base) * source->ns_per_tick);
+#endif
+
+  clock_gettime (source->clock_id, &ts);
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+G_GNUC_INTERNAL void gst_timing_time_source_init_monotonic (
+    GstTimingTimeSource * source);
+G_GNUC_INTERNAL gboolean gst_timing_time_source_init_monotonic_coarse (
+    GstTimingTimeSource * source);
+G_GNUC_INTERNAL gboolean gst_timing_time_source_init_tsc (
+    GstTimingTimeSource * source);
+
+G_END_DECLS
+
+#endif /* __GST_TIMING_TIME_SOURCE_H__ */
@@ -0,0 +1,231 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* Measures the per-buffer cost of throughput in its different modes against
+ * a bare identity, driven through GstHarness, in ns and heap allocations per
+ * buffer. Run it with "make bench".
+ *
+ * Allocations are counted by interposing malloc, calloc and realloc, which
+ * needs glibc; run with G_SLICE=always-malloc so GSlice allocations are
+ * counted as well (the bench target does). */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+#define DEFAULT_BUFFERS 200000
+#define LIST_LENGTH     64
+
+#define BENCH_CAPS      "application/x-bench"
+#define VIDEO_CAPS      "video/x-raw,format=I420,width=320,height=240," \
+    "framerate=30/1"
+#define AUDIO_CAPS      "audio/x-raw,format=S16LE,layout=interleaved," \
+    "rate=48000,channels=2"
+
+static volatile gint allocations = 0;
+static gboolean counting = FALSE;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+void *
+malloc (size_t size)
+{
+  if (counting)
+    g_atomic_int_inc (&allocations);
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  if (counting)
+    g_atomic_int_inc (&allocations);
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  if (counting)
+    g_atomic_int_inc (&allocations);
+  return __libc_realloc (ptr, size);
+}
+#endif
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *element;
+  const gchar *properties;
+  /* BENCH_CAPS if NULL, raw caps take the per-unit paths of the meter */
+  const gchar *caps;
+} BenchCase;
+
+static const BenchCase cases[] = {
+  {"identity", "identity", "silent=true"},
+  {"throughput", "throughput", ""},
+  {"sync", "throughput", "sync=true"},
+  {"sync-every=16", "throughput", "sync=true sync-every=16"},
+  {"silent=false", "throughput", "silent=false"},
+  {"stderr", "throughput", "stderr=true"},
+  {"no-messages", "throughput", "post-messages=false"},
+  {"histograms", "throughput", "histograms=true"},
+  {"hist-monotonic", "throughput", "histograms=true clock-source=monotonic"},
+  {"hist-coarse", "throughput",
+      "histograms=true clock-source=monotonic-coarse"},
+  {"hist-tsc", "throughput", "histograms=true clock-source=tsc"},
+  {"backpressure", "throughput", "backpressure=true"},
+  {"backpressure-tsc", "throughput", "backpressure=true clock-source=tsc"},
+  {"memory", "throughput", "memory=true"},
+  {"video", "throughput", "", VIDEO_CAPS},
+  {"video-hist", "throughput", "histograms=true", VIDEO_CAPS},
+  {"audio", "throughput", "", AUDIO_CAPS},
+};
+
+static const gsize sizes[] = { 64, 1500, 65536, 1048576 };
+
+static GstHarness *
+bench_harness_new (const BenchCase * c)
+{
+  GstElement *element;
+  gchar **props, **p, *value;
+
+  element = gst_element_factory_make (c->element, NULL);
+  if (!element) {
+    g_printerr ("%s not found, is GST_PLUGIN_PATH set?\n", c->element);
+    exit (1);
+  }
+
+  props = g_strsplit (c->properties, " ", -1);
+  for (p = props; *p; p++) {
+    if (!(value = strchr (*p, '=')))
+      continue;
+    *value++ = '\0';
+    gst_util_set_object_arg (G_OBJECT (element), *p, value);
+  }
+  g_strfreev (props);
+
+  return gst_harness_new_with_element (element, "sink", "src");
+}
+
+/* pushes @n buffers of @size either one by one or as lists, returns the ns
+ * spent per buffer and stores the allocations per buffer */
+static gdouble
+bench_run (const BenchCase * c, gsize size, gboolean lists, guint n,
+    gdouble * allocs)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstBufferList *list = NULL;
+  GstClockTime start, stop;
+  guint i;
+
+  h = bench_harness_new (c);
+  gst_harness_set_src_caps_str (h, c->caps ? c->caps : BENCH_CAPS);
+  gst_harness_set_drop_buffers (h, TRUE);
+
+  /* timestamps in the past, so sync=true measures the cost of the clock
+   * entry and not the wait */
+  buf = gst_harness_create_buffer (h, size);
+  GST_BUFFER_PTS (buf) = 0;
+
+  if (lists) {
+    list = gst_buffer_list_new_sized (LIST_LENGTH);
+    for (i = 0; i < LIST_LENGTH; i++)
+      gst_buffer_list_add (list, gst_buffer_ref (buf));
+    n -= n % LIST_LENGTH;
+  }
+
+  /* warm up, the first buffers negotiate and allocate the element state */
+  for (i = 0; i < 1000; i++)
+    gst_harness_push (h, gst_buffer_ref (buf));
+
+  allocations = 0;
+  counting = TRUE;
+  start = gst_util_get_timestamp ();
+  if (lists) {
+    for (i = 0; i < n; i += LIST_LENGTH)
+      gst_pad_push_list (h->srcpad, gst_buffer_list_ref (list));
+  } else {
+    for (i = 0; i < n; i++)
+      gst_harness_push (h, gst_buffer_ref (buf));
+  }
+  stop = gst_util_get_timestamp ();
+  counting = FALSE;
+
+  *allocs = (gdouble) g_atomic_int_get (&allocations) / n;
+
+  if (list)
+    gst_buffer_list_unref (list);
+  gst_buffer_unref (buf);
+  gst_harness_teardown (h);
+
+  return (gdouble) (stop - start) / n;
+}
+
+static void
+drop_log (const gchar * log_domain, GLogLevelFlags log_level,
+    const gchar * message, gpointer user_data)
+{
+}
+
+int
+main (int argc, char *argv[])
+{
+  guint n = DEFAULT_BUFFERS;
+  gdouble ns, allocs, base_ns[G_N_ELEMENTS (sizes)][2];
+  guint c, s, lists;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    n = MAX (strtoul (argv[1], NULL, 10), LIST_LENGTH);
+
+  /* stderr=true prints a g_message per interval, keep the table readable */
+  g_log_set_handler (NULL, G_LOG_LEVEL_MESSAGE, drop_log, NULL);
+
+  g_print ("%-16s %8s %6s %10s %10s %12s\n", "case", "size", "lists",
+      "ns/buffer", "vs ident", "allocs/buf");
+
+  for (c = 0; c < G_N_ELEMENTS (cases); c++) {
+    for (s = 0; s < G_N_ELEMENTS (sizes); s++) {
+      for (lists = 0; lists < 2; lists++) {
+        ns = bench_run (&cases[c], sizes[s], lists, n, &allocs);
+        if (c == 0)
+          base_ns[s][lists] = ns;
+
+        g_print ("%-16s %8" G_GSIZE_FORMAT " %6s %10.1f %+10.1f %12.2f\n",
+            cases[c].name, sizes[s], lists ? "yes" : "no", ns,
+            ns - base_ns[s][lists], allocs);
+      }
+    }
+  }
+
+#ifndef __GLIBC__
+  g_print ("allocations are only counted with glibc\n");
+#endif
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* latencystamp feeding latencyprobe through two GstHarness, so the stamped
+ * buffers can be dropped and reordered on the way. The probe reports on the
+ * system clock, the test waits for the reports to catch up. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define OPAQUE_CAPS "application/octet-stream"
+#define N_BUFFERS 80
+
+/* polls the stats of the probe until one has the field with at least min */
+static GstStructure *
+wait_for_stats (GstHarness * probe, const gchar * field, guint64 min)
+{
+  GstStructure *stats;
+  guint64 value;
+
+  for (;;) {
+    g_object_get (probe->element, "stats", &stats, NULL);
+    if (stats && gst_structure_get_uint64 (stats, field, &value) &&
+        value >= min)
+      return stats;
+    if (stats)
+      gst_structure_free (stats);
+    g_usleep (5000);
+  }
+}
+
+static void
+push_to_probe (GstHarness * probe, GstBuffer * buf)
+{
+  fail_unless_equals_int (gst_harness_push (probe, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (probe));
+}
+
+GST_START_TEST (test_stamp_to_probe)
+{
+  GstHarness *stamp, *probe;
+  GstBuffer *bufs[N_BUFFERS];
+  GstStructure *stats;
+  guint64 value;
+  guint i;
+
+  stamp = gst_harness_new ("latencystamp");
+  probe = gst_harness_new ("latencyprobe");
+  g_object_set (probe->element, "interval", 10, NULL);
+  gst_harness_set_src_caps_str (stamp, OPAQUE_CAPS);
+  gst_harness_set_src_caps_str (probe, OPAQUE_CAPS);
+
+  /* the first report only starts the totals */
+  gst_structure_free (wait_for_stats (probe, "total-latency-count", 0));
+
+  for (i = 0; i < N_BUFFERS; i++) {
+    fail_unless_equals_int (gst_harness_push (stamp,
+            gst_harness_create_buffer (stamp, 64)), GST_FLOW_OK);
+    bufs[i] = gst_harness_pull (stamp);
+  }
+
+  /* 2 overtakes 1 and 4 never arrives */
+  push_to_probe (probe, bufs[0]);
+  push_to_probe (probe, bufs[2]);
+  push_to_probe (probe, bufs[1]);
+  push_to_probe (probe, bufs[3]);
+  gst_buffer_unref (bufs[4]);
+  for (i = 5; i < N_BUFFERS; i++)
+    push_to_probe (probe, bufs[i]);
+  push_to_probe (probe, gst_harness_create_buffer (probe, 64));
+
+  stats = wait_for_stats (probe, "total-latency-count", N_BUFFERS - 1);
+  fail_unless (gst_structure_get_uint64 (stats, "total-latency-count",
+          &value));
+  fail_unless_equals_uint64 (value, N_BUFFERS - 1);
+  fail_unless (gst_structure_get_uint64 (stats, "lost", &value));
+  fail_unless_equals_uint64 (value, 1);
+  fail_unless (gst_structure_get_uint64 (stats, "unstamped", &value));
+  fail_unless_equals_uint64 (value, 1);
+  /* nothing waited on the way, no buffer took anywhere near a second */
+  fail_unless (gst_structure_get_uint64 (stats, "total-latency-max", &value));
+  fail_unless (value < GST_SECOND);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (stamp);
+  gst_harness_teardown (probe);
+}
+
+GST_END_TEST;
+
+static Suite *
+latency_suite (void)
+{
+  Suite *s = suite_create ("latency");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_stamp_to_probe);
+
+  return s;
+}
+
+GST_CHECK_MAIN (latency);
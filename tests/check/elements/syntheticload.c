@@ -0,0 +1,131 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* The drop and delay schedule of syntheticload and the latency it adds to
+ * the latency query. The holding itself runs on the real monotonic clock,
+ * so the times are kept short. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define OPAQUE_CAPS "application/octet-stream"
+
+static GstHarness *
+setup_load (const gchar * first, ...)
+{
+  GstElement *element;
+  GstHarness *h;
+  va_list args;
+
+  element = gst_element_factory_make ("syntheticload", NULL);
+  fail_unless (element != NULL);
+
+  va_start (args, first);
+  if (first)
+    g_object_set_valist (G_OBJECT (element), first, args);
+  va_end (args);
+
+  h = gst_harness_new_with_element (element, "sink", "src");
+  gst_object_unref (element);
+  gst_harness_set_src_caps_str (h, OPAQUE_CAPS);
+
+  return h;
+}
+
+GST_START_TEST (test_drop_every)
+{
+  GstHarness *h;
+  guint64 dropped;
+  guint i;
+
+  h = setup_load ("drop-every", 3, NULL);
+
+  for (i = 0; i < 9; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            gst_harness_create_buffer (h, 1024)), GST_FLOW_OK);
+
+  fail_unless_equals_int (gst_harness_buffers_received (h), 6);
+  g_object_get (h->element, "dropped", &dropped, NULL);
+  fail_unless_equals_uint64 (dropped, 3);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_delay_every)
+{
+  GstHarness *h;
+  GstClockTime start;
+  guint64 delayed;
+  guint i;
+
+  h = setup_load ("delay-every", 2, "delay", 2 * GST_MSECOND,
+      "cpu-per-buffer", 100 * GST_USECOND, NULL);
+
+  start = g_get_monotonic_time () * GST_USECOND;
+  for (i = 0; i < 4; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            gst_harness_create_buffer (h, 1024)), GST_FLOW_OK);
+
+  /* every buffer passes, the second and the fourth one late */
+  fail_unless_equals_int (gst_harness_buffers_received (h), 4);
+  g_object_get (h->element, "delayed", &delayed, NULL);
+  fail_unless_equals_uint64 (delayed, 2);
+  fail_unless (g_get_monotonic_time () * GST_USECOND - start >=
+      4 * GST_MSECOND);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_latency_query)
+{
+  GstHarness *h;
+
+  h = setup_load ("latency", 20 * GST_MSECOND,
+      "latency-jitter", 5 * GST_MSECOND, "delay-every", 10,
+      "delay", 10 * GST_MSECOND, NULL);
+
+  /* the worst case a buffer can be held back */
+  fail_unless_equals_uint64 (gst_harness_query_latency (h),
+      35 * GST_MSECOND);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+syntheticload_suite (void)
+{
+  Suite *s = suite_create ("syntheticload");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_drop_every);
+  tcase_add_test (tc_chain, test_delay_every);
+  tcase_add_test (tc_chain, test_latency_query);
+
+  return s;
+}
+
+GST_CHECK_MAIN (syntheticload);
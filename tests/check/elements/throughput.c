@@ -0,0 +1,839 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* Exact rates of the throughput element, measured on the GstTestClock of a
+ * GstHarness with clock-source=pipeline, so every interval is exactly as
+ * long as the test says. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define VIDEO_CAPS "video/x-raw,format=I420,width=32,height=24," \
+    "framerate=30000/1001"
+#define AUDIO_CAPS "audio/x-raw,format=S16LE,layout=interleaved," \
+    "rate=48000,channels=2"
+#define OPAQUE_CAPS "application/octet-stream"
+
+static GstHarness *
+setup_throughput (const gchar * caps, const gchar * first, ...)
+{
+  GstElement *element;
+  GstHarness *h;
+  va_list args;
+
+  element = gst_element_factory_make ("throughput", NULL);
+  fail_unless (element != NULL);
+  gst_util_set_object_arg (G_OBJECT (element), "clock-source", "pipeline");
+
+  va_start (args, first);
+  if (first)
+    g_object_set_valist (G_OBJECT (element), first, args);
+  va_end (args);
+
+  h = gst_harness_new_with_element (element, "sink", "src");
+  gst_object_unref (element);
+  gst_harness_set_src_caps_str (h, caps);
+
+  return h;
+}
+
+static void
+push_buffer (GstHarness * h, gsize size, guint64 offset)
+{
+  GstBuffer *buf = gst_harness_create_buffer (h, size);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+}
+
+/* fires the next report tick of the element and returns its stats */
+static GstStructure *
+crank_report (GstHarness * h)
+{
+  GstStructure *stats = NULL;
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+
+  return stats;
+}
+
+static void
+assert_stats_double (const GstStructure * stats, const gchar * field,
+    gdouble expected)
+{
+  gdouble value;
+
+  fail_unless (gst_structure_get_double (stats, field, &value), field);
+  fail_unless (value == expected, "%s: %f != %f", field, value, expected);
+}
+
+static void
+assert_stats_uint64 (const GstStructure * stats, const gchar * field,
+    guint64 expected)
+{
+  guint64 value;
+
+  fail_unless (gst_structure_get_uint64 (stats, field, &value), field);
+  fail_unless_equals_uint64 (value, expected);
+}
+
+GST_START_TEST (test_video)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  gchar *message;
+  guint i;
+
+  h = setup_throughput (VIDEO_CAPS, "interval", 1000, "silent", FALSE, NULL);
+
+  /* the first tick only starts the first interval */
+  push_buffer (h, 1152, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  for (i = 1; i <= 30; i++)
+    push_buffer (h, 1152, i);
+  stats = crank_report (h);
+
+  fail_unless_equals_string (gst_structure_get_string (stats, "media-kind"),
+      "video");
+  assert_stats_uint64 (stats, "interval", GST_SECOND);
+  assert_stats_uint64 (stats, "interval-buffers", 30);
+  assert_stats_uint64 (stats, "interval-offsets", 30);
+  assert_stats_double (stats, "nominal-rate", 30000.0 / 1001.0);
+  assert_stats_double (stats, "buffers-per-second", 30.0);
+  assert_stats_double (stats, "offsets-per-second", 30.0);
+  assert_stats_double (stats, "bytes-per-second", 30.0 * 1152);
+  assert_stats_double (stats, "bits-per-second", 30.0 * 1152 * 8);
+  gst_structure_free (stats);
+
+  g_object_get (h->element, "last-message", &message, NULL);
+  fail_unless_equals_string (message,
+      "Transfering 30 Buffers/s (30 Frames/s) of a 30 Frames/s stream "
+      "(=100.1%) at 0.26 MBit/s (= 0.03 MByte/s)");
+  g_free (message);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_audio)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  guint i;
+
+  h = setup_throughput (AUDIO_CAPS, "interval", 500, NULL);
+
+  push_buffer (h, 1920, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* 50 buffers of 480 samples in 500ms */
+  for (i = 1; i <= 50; i++)
+    push_buffer (h, 1920, i * 480);
+  stats = crank_report (h);
+
+  fail_unless_equals_string (gst_structure_get_string (stats, "media-kind"),
+      "audio");
+  assert_stats_uint64 (stats, "interval", 500 * GST_MSECOND);
+  assert_stats_uint64 (stats, "interval-offsets", 50 * 480);
+  assert_stats_double (stats, "nominal-rate", 48000.0);
+  assert_stats_double (stats, "buffers-per-second", 100.0);
+  assert_stats_double (stats, "offsets-per-second", 48000.0);
+  assert_stats_double (stats, "bytes-per-second", 192000.0);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_audio_without_offsets)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  guint i;
+
+  h = setup_throughput (AUDIO_CAPS, "interval", 500, NULL);
+
+  push_buffer (h, 1920, GST_BUFFER_OFFSET_NONE);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* 480 samples of 4 bytes each, counted from the size */
+  for (i = 1; i <= 50; i++)
+    push_buffer (h, 1920, GST_BUFFER_OFFSET_NONE);
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "interval-offsets", 50 * 480);
+  assert_stats_double (stats, "offsets-per-second", 48000.0);
+  assert_stats_double (stats, "expected-bits-per-second", 1536000.0);
+  assert_stats_double (stats, "efficiency", 1.0);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_opaque)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  guint i;
+
+  h = setup_throughput (OPAQUE_CAPS, "interval", 250, NULL);
+
+  push_buffer (h, 100, GST_BUFFER_OFFSET_NONE);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  for (i = 0; i < 10; i++)
+    push_buffer (h, 100, GST_BUFFER_OFFSET_NONE);
+  stats = crank_report (h);
+
+  fail_unless_equals_string (gst_structure_get_string (stats, "media-kind"),
+      "other");
+  assert_stats_uint64 (stats, "interval", 250 * GST_MSECOND);
+  assert_stats_double (stats, "nominal-rate", 0.0);
+  assert_stats_double (stats, "buffers-per-second", 40.0);
+  assert_stats_double (stats, "bytes-per-second", 4000.0);
+  assert_stats_double (stats, "offsets-per-second", 0.0);
+  gst_structure_free (stats);
+
+  /* an interval without buffers is not reported */
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  for (i = 0; i < 5; i++)
+    push_buffer (h, 100, GST_BUFFER_OFFSET_NONE);
+  stats = crank_report (h);
+  assert_stats_uint64 (stats, "interval", 250 * GST_MSECOND);
+  assert_stats_double (stats, "buffers-per-second", 20.0);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_buffer_list)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  GstBufferList *list;
+  GstPad *srcpad;
+  gint64 position;
+  guint i;
+
+  h = setup_throughput (VIDEO_CAPS, "interval", 1000, NULL);
+
+  push_buffer (h, 1152, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  list = gst_buffer_list_new ();
+  for (i = 1; i <= 10; i++) {
+    GstBuffer *buf = gst_harness_create_buffer (h, 1152);
+
+    GST_BUFFER_OFFSET (buf) = i;
+    GST_BUFFER_PTS (buf) = i * 40 * GST_MSECOND;
+    GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+    gst_buffer_list_add (list, buf);
+  }
+  fail_unless_equals_int (gst_pad_push_list (h->srcpad, list), GST_FLOW_OK);
+  stats = crank_report (h);
+
+  /* the segment position is kept up to date as for single buffers */
+  srcpad = gst_element_get_static_pad (h->element, "src");
+  fail_unless (gst_pad_query_position (srcpad, GST_FORMAT_TIME, &position));
+  gst_object_unref (srcpad);
+  fail_unless_equals_int64 (position, 440 * GST_MSECOND);
+
+  assert_stats_uint64 (stats, "interval-buffers", 10);
+  assert_stats_uint64 (stats, "interval-bytes", 11520);
+  assert_stats_uint64 (stats, "interval-offsets", 10);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_gap_histogram)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  guint i;
+
+  h = setup_throughput (OPAQUE_CAPS, "interval", 1000, "histograms", TRUE,
+      NULL);
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* a buffer every 100ms from 1s on */
+  for (i = 0; i <= 9; i++) {
+    gst_harness_set_time (h, GST_SECOND + i * 100 * GST_MSECOND);
+    push_buffer (h, 100, GST_BUFFER_OFFSET_NONE);
+  }
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "interval-buffers", 10);
+  assert_stats_uint64 (stats, "gap-count", 9);
+  assert_stats_uint64 (stats, "gap-min", 100 * GST_MSECOND);
+  assert_stats_uint64 (stats, "gap-p50", 100 * GST_MSECOND);
+  assert_stats_uint64 (stats, "gap-max", 100 * GST_MSECOND);
+  assert_stats_uint64 (stats, "size-p99", 100);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_realtime_factor)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  GstBuffer *buf;
+  gdouble factor;
+  guint i;
+
+  h = setup_throughput (VIDEO_CAPS, "interval", 1000, "silent", FALSE, NULL);
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* 2s of media in 1s of wall-clock time */
+  for (i = 0; i < 50; i++) {
+    buf = gst_harness_create_buffer (h, 1152);
+    GST_BUFFER_PTS (buf) = i * 40 * GST_MSECOND;
+    GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+    gst_buffer_unref (gst_harness_pull (h));
+
+    /* the first interval only sets the starting point */
+    if (i == 0)
+      fail_unless (gst_harness_crank_single_clock_wait (h));
+  }
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "media-time", 49 * 40 * GST_MSECOND);
+  fail_unless (gst_structure_get_double (stats, "realtime-factor", &factor));
+  fail_unless (factor == 1.96, "realtime-factor %f", factor);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static void
+push_buffer_at (GstHarness * h, GstClockTime pts)
+{
+  GstBuffer *buf = gst_harness_create_buffer (h, 100);
+
+  GST_BUFFER_PTS (buf) = pts;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+}
+
+GST_START_TEST (test_lateness)
+{
+  GstHarness *h;
+  GstStructure *stats;
+
+  h = setup_throughput (OPAQUE_CAPS, "interval", 1000, "lateness", TRUE,
+      NULL);
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* base-time and latency are 0, so the deadline is the running time */
+  gst_harness_set_time (h, 1500 * GST_MSECOND);
+  push_buffer_at (h, 1000 * GST_MSECOND);
+  push_buffer_at (h, 1600 * GST_MSECOND);
+  push_buffer_at (h, 1200 * GST_MSECOND);
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "late-buffers", 2);
+  assert_stats_uint64 (stats, "total-late-buffers", 2);
+  assert_stats_uint64 (stats, "lateness-min", 300 * GST_MSECOND);
+  assert_stats_uint64 (stats, "lateness-max", 500 * GST_MSECOND);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* the deadline is the PTS, so a reordered stream is not late by its DTS,
+ * and late buffers send one QoS event per interval */
+GST_START_TEST (test_lateness_qos)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  GstBuffer *buf;
+  GstEvent *event;
+  GstClockTime timestamp;
+  GstClockTimeDiff diff;
+
+  h = setup_throughput (OPAQUE_CAPS, "interval", 1000, "lateness", TRUE,
+      "qos", TRUE, NULL);
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  gst_harness_set_time (h, 1500 * GST_MSECOND);
+
+  buf = gst_harness_create_buffer (h, 16);
+  GST_BUFFER_DTS (buf) = 1400 * GST_MSECOND;
+  GST_BUFFER_PTS (buf) = 1600 * GST_MSECOND;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  push_buffer_at (h, 1000 * GST_MSECOND);
+  push_buffer_at (h, 1100 * GST_MSECOND);
+  push_buffer_at (h, 1200 * GST_MSECOND);
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "late-buffers", 3);
+  gst_structure_free (stats);
+
+  /* skip the events the harness sent upstream itself */
+  while ((event = gst_harness_try_pull_upstream_event (h))) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_QOS)
+      break;
+    gst_event_unref (event);
+  }
+  fail_unless (event != NULL);
+  gst_event_parse_qos (event, NULL, NULL, &diff, &timestamp);
+  fail_unless_equals_uint64 (timestamp, 1000 * GST_MSECOND);
+  fail_unless_equals_int64 (diff, 500 * GST_MSECOND);
+  gst_event_unref (event);
+
+  while ((event = gst_harness_try_pull_upstream_event (h))) {
+    fail_if (GST_EVENT_TYPE (event) == GST_EVENT_QOS);
+    gst_event_unref (event);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_loss)
+{
+  static const guint64 offsets[] = { 1, 2, 5, 6, 7 };
+  GstHarness *h;
+  GstStructure *stats;
+  GstBuffer *buf;
+  guint i;
+
+  h = setup_throughput (VIDEO_CAPS, "interval", 1000, NULL);
+
+  push_buffer (h, 1152, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* frames 3 and 4 are missing, the stream continues with a DISCONT */
+  for (i = 0; i < G_N_ELEMENTS (offsets); i++) {
+    buf = gst_harness_create_buffer (h, 1152);
+    GST_BUFFER_OFFSET (buf) = offsets[i];
+    GST_BUFFER_OFFSET_END (buf) = offsets[i] + 1;
+    GST_BUFFER_PTS (buf) = offsets[i] * 40 * GST_MSECOND;
+    GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+    if (offsets[i] == 5)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+    gst_buffer_unref (gst_harness_pull (h));
+  }
+  fail_unless (gst_harness_push_event (h,
+          gst_event_new_gap (320 * GST_MSECOND, 80 * GST_MSECOND)));
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "interval-offsets", 5);
+  assert_stats_uint64 (stats, "missing-offsets", 2);
+  assert_stats_uint64 (stats, "missing-time", 80 * GST_MSECOND);
+  assert_stats_uint64 (stats, "discont-buffers", 1);
+  assert_stats_uint64 (stats, "gap-events", 1);
+  assert_stats_uint64 (stats, "gap-time", 80 * GST_MSECOND);
+  assert_stats_double (stats, "loss-ratio", 2.0 / 7.0);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_aligned_reports)
+{
+  GstHarness *h;
+  GstElement *raw, *encoded;
+  GstStructure *raw_stats, *encoded_stats;
+  GstTestClock *clock;
+  guint64 raw_timestamp, encoded_timestamp;
+  guint i;
+
+  h = gst_harness_new_parse ("throughput name=raw clock-source=pipeline ! "
+      "throughput name=encoded clock-source=pipeline");
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS);
+  raw = gst_bin_get_by_name (GST_BIN (h->element), "raw");
+  encoded = gst_bin_get_by_name (GST_BIN (h->element), "encoded");
+
+  /* both elements are ticked by a single clock id */
+  clock = gst_harness_get_testclock (h);
+  gst_test_clock_wait_for_next_pending_id (clock, NULL);
+  fail_unless_equals_int (gst_test_clock_peek_id_count (clock), 1);
+
+  push_buffer (h, 1152, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  for (i = 1; i <= 30; i++)
+    push_buffer (h, 1152, i);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  g_object_get (raw, "stats", &raw_stats, NULL);
+  g_object_get (encoded, "stats", &encoded_stats, NULL);
+  fail_unless (raw_stats != NULL);
+  fail_unless (encoded_stats != NULL);
+  fail_unless (gst_structure_get_uint64 (raw_stats, "timestamp",
+          &raw_timestamp));
+  fail_unless (gst_structure_get_uint64 (encoded_stats, "timestamp",
+          &encoded_timestamp));
+  fail_unless_equals_uint64 (raw_timestamp, encoded_timestamp);
+  assert_stats_uint64 (raw_stats, "interval-buffers", 30);
+  assert_stats_uint64 (encoded_stats, "interval-buffers", 30);
+  gst_structure_free (raw_stats);
+  gst_structure_free (encoded_stats);
+
+  gst_object_unref (clock);
+  gst_object_unref (raw);
+  gst_object_unref (encoded);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static void
+push_frame (GstHarness * h, gsize size, guint64 offset, GstBufferFlags flags)
+{
+  GstBuffer *buf = gst_harness_create_buffer (h, size);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  if (offset != GST_BUFFER_OFFSET_NONE) {
+    GST_BUFFER_PTS (buf) = offset * 40 * GST_MSECOND;
+    GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+  }
+  GST_BUFFER_FLAG_SET (buf, flags);
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+}
+
+GST_START_TEST (test_frame_types)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  guint64 i;
+
+  h = setup_throughput ("video/x-h264", "interval", 1000,
+      "frame-types", TRUE, NULL);
+
+  push_frame (h, 30, GST_BUFFER_OFFSET_NONE, GST_BUFFER_FLAG_HEADER);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* I P P P I P P P I */
+  for (i = 0; i < 9; i++) {
+    if (i % 4 == 0)
+      push_frame (h, 1000, i, 0);
+    else
+      push_frame (h, 100, i, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "keyframes", 3);
+  assert_stats_uint64 (stats, "delta-frames", 6);
+  assert_stats_double (stats, "keyframe-bytes-per-second", 3000.0);
+  assert_stats_double (stats, "delta-bytes-per-second", 600.0);
+  assert_stats_uint64 (stats, "gop-count", 2);
+  assert_stats_uint64 (stats, "gop-min", 4);
+  assert_stats_uint64 (stats, "gop-max", 4);
+  assert_stats_uint64 (stats, "keyframe-interval-min", 160 * GST_MSECOND);
+  assert_stats_uint64 (stats, "keyframe-interval-max", 160 * GST_MSECOND);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ignore_flags)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  guint64 i;
+
+  h = setup_throughput (VIDEO_CAPS, "interval", 1000,
+      "ignore-flags", GST_BUFFER_FLAG_HEADER, NULL);
+
+  push_buffer (h, 1152, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* the headers still pass, but are not measured */
+  for (i = 1; i <= 10; i++) {
+    push_frame (h, 64, GST_BUFFER_OFFSET_NONE, GST_BUFFER_FLAG_HEADER);
+    push_buffer (h, 1152, i);
+  }
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "interval-buffers", 10);
+  assert_stats_uint64 (stats, "interval-bytes", 11520);
+  assert_stats_uint64 (stats, "interval-offsets", 10);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static gint
+compare_names (const gchar ** a, const gchar ** b)
+{
+  return g_strcmp0 (*a, *b);
+}
+
+/* the next "throughput-report" on bus, with the sorted names of its
+ * measurements */
+static gchar *
+pop_report_elements (GstBus * bus)
+{
+  GstMessage *message;
+  const GstStructure *s;
+  const GValue *measurements;
+  GPtrArray *names = g_ptr_array_new_with_free_func (g_free);
+  gchar *joined;
+  guint i;
+
+  while ((message = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT))) {
+    s = gst_message_get_structure (message);
+    if (gst_structure_has_name (s, "throughput-report"))
+      break;
+    gst_message_unref (message);
+  }
+  fail_unless (message != NULL);
+
+  measurements = gst_structure_get_value (s, "measurements");
+  for (i = 0; i < gst_value_array_get_size (measurements); i++) {
+    s = gst_value_get_structure (gst_value_array_get_value (measurements, i));
+    g_ptr_array_add (names, g_strdup (gst_structure_get_string (s,
+                "element")));
+  }
+  gst_message_unref (message);
+
+  g_ptr_array_sort (names, (GCompareFunc) compare_names);
+  g_ptr_array_add (names, NULL);
+  joined = g_strjoinv (",", (gchar **) names->pdata);
+  g_ptr_array_unref (names);
+
+  return joined;
+}
+
+GST_START_TEST (test_reports_per_pipeline)
+{
+  GstHarness *a, *b;
+  GstTestClock *clock;
+  GstBus *bus_a, *bus_b;
+  gchar *names;
+  guint i;
+
+  a = gst_harness_new_parse ("throughput name=a1 clock-source=pipeline ! "
+      "throughput name=a2 clock-source=pipeline");
+  b = gst_harness_new_parse ("throughput name=b1 clock-source=pipeline ! "
+      "throughput name=b2 clock-source=pipeline");
+  gst_harness_set_src_caps_str (a, VIDEO_CAPS);
+  gst_harness_set_src_caps_str (b, VIDEO_CAPS);
+  bus_a = gst_bus_new ();
+  bus_b = gst_bus_new ();
+  gst_element_set_bus (a->element, bus_a);
+  gst_element_set_bus (b->element, bus_b);
+
+  /* both pipelines on one clock end up in one group with a single tick */
+  clock = gst_harness_get_testclock (a);
+  gst_element_set_clock (b->element, GST_CLOCK_CAST (clock));
+  gst_test_clock_wait_for_next_pending_id (clock, NULL);
+  fail_unless_equals_int (gst_test_clock_peek_id_count (clock), 1);
+
+  push_buffer (a, 1152, 0);
+  push_buffer (b, 1152, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (a));
+
+  for (i = 1; i <= 10; i++) {
+    push_buffer (a, 1152, i);
+    push_buffer (b, 1152, i);
+  }
+  fail_unless (gst_harness_crank_single_clock_wait (a));
+
+  /* but each pipeline only gets the report of its own elements */
+  names = pop_report_elements (bus_a);
+  fail_unless_equals_string (names, "a1,a2");
+  g_free (names);
+  names = pop_report_elements (bus_b);
+  fail_unless_equals_string (names, "b1,b2");
+  g_free (names);
+
+  gst_object_unref (clock);
+  gst_object_unref (bus_a);
+  gst_object_unref (bus_b);
+  gst_harness_teardown (a);
+  gst_harness_teardown (b);
+}
+
+GST_END_TEST;
+
+/* downstream takes 5ms for every buffer */
+static GstPadProbeReturn
+slow_downstream_probe (GstPad * pad, GstPadProbeInfo * info, gpointer data)
+{
+  gst_test_clock_advance_time (GST_TEST_CLOCK (data), 5 * GST_MSECOND);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_backpressure)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  GstTestClock *clock;
+  GstPad *srcpad;
+  guint i;
+
+  h = setup_throughput (VIDEO_CAPS, "interval", 1000, "backpressure", TRUE,
+      NULL);
+  clock = gst_harness_get_testclock (h);
+  srcpad = gst_element_get_static_pad (h->element, "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER, slow_downstream_probe,
+      clock, NULL);
+  gst_object_unref (srcpad);
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* upstream takes 15ms for every buffer after the first */
+  for (i = 0; i < 10; i++) {
+    if (i > 0)
+      gst_test_clock_advance_time (clock, 15 * GST_MSECOND);
+    push_buffer (h, 1152, i);
+  }
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "blocked-time", 50 * GST_MSECOND);
+  assert_stats_uint64 (stats, "starved-time", 135 * GST_MSECOND);
+  assert_stats_double (stats, "blocked-ratio", 0.05);
+  assert_stats_double (stats, "starved-ratio", 0.135);
+  assert_stats_uint64 (stats, "push-duration-count", 10);
+  assert_stats_uint64 (stats, "push-duration-min", 5 * GST_MSECOND);
+  assert_stats_uint64 (stats, "push-duration-max", 5 * GST_MSECOND);
+  gst_structure_free (stats);
+
+  gst_object_unref (clock);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_memory)
+{
+  GstHarness *h;
+  GstStructure *stats;
+  const GstStructure *allocators;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstBuffer *buf;
+  guint i;
+
+  h = setup_throughput (VIDEO_CAPS, "interval", 1000, "memory", TRUE, NULL);
+
+  /* a pool of one buffer hands out the same memory every time */
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, 1152, 1, 1);
+  fail_unless (gst_buffer_pool_set_config (pool, config));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  for (i = 0; i < 4; i++) {
+    fail_unless_equals_int (gst_buffer_pool_acquire_buffer (pool, &buf, NULL),
+        GST_FLOW_OK);
+    GST_BUFFER_OFFSET (buf) = i;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+    gst_buffer_unref (gst_harness_pull (h));
+  }
+
+  /* and one buffer of two fresh memories from outside the pool */
+  buf = gst_harness_create_buffer (h, 576);
+  gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 576, NULL));
+  GST_BUFFER_OFFSET (buf) = 4;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  stats = crank_report (h);
+
+  assert_stats_uint64 (stats, "memories", 6);
+  assert_stats_uint64 (stats, "pooled-buffers", 4);
+  assert_stats_uint64 (stats, "recycled-memories", 3);
+  assert_stats_uint64 (stats, "fresh-memories", 3);
+  assert_stats_double (stats, "pooled-ratio", 0.8);
+  assert_stats_double (stats, "recycled-ratio", 0.5);
+  assert_stats_uint64 (stats, "memories-per-buffer-count", 5);
+  assert_stats_uint64 (stats, "memories-per-buffer-max", 2);
+
+  allocators = gst_value_get_structure (gst_structure_get_value (stats,
+          "allocators"));
+  assert_stats_uint64 (allocators, GST_ALLOCATOR_SYSMEM, 6);
+  gst_structure_free (stats);
+
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+  gst_object_unref (pool);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+throughput_suite (void)
+{
+  Suite *s = suite_create ("throughput");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_video);
+  tcase_add_test (tc_chain, test_audio);
+  tcase_add_test (tc_chain, test_audio_without_offsets);
+  tcase_add_test (tc_chain, test_opaque);
+  tcase_add_test (tc_chain, test_buffer_list);
+  tcase_add_test (tc_chain, test_gap_histogram);
+  tcase_add_test (tc_chain, test_realtime_factor);
+  tcase_add_test (tc_chain, test_lateness);
+  tcase_add_test (tc_chain, test_lateness_qos);
+  tcase_add_test (tc_chain, test_loss);
+  tcase_add_test (tc_chain, test_frame_types);
+  tcase_add_test (tc_chain, test_ignore_flags);
+  tcase_add_test (tc_chain, test_aligned_reports);
+  tcase_add_test (tc_chain, test_reports_per_pipeline);
+  tcase_add_test (tc_chain, test_backpressure);
+  tcase_add_test (tc_chain, test_memory);
+
+  return s;
+}
+
+GST_CHECK_MAIN (throughput);
@@ -0,0 +1,163 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* Per-stream and total rates of throughputmux with two streams, one
+ * GstHarness per pad pair. The reports tick on the GstTestClock of the
+ * harness that was added last, which is the clock the element ends up
+ * with. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define VIDEO_CAPS "video/x-raw,format=I420,width=32,height=24," \
+    "framerate=30000/1001"
+#define AUDIO_CAPS "audio/x-raw,format=S16LE,layout=interleaved," \
+    "rate=48000,channels=2"
+
+/* gst_element_get_request_pad() is deprecated since 1.20 */
+#if !GST_CHECK_VERSION(1, 20, 0)
+#define gst_element_request_pad_simple gst_element_get_request_pad
+#endif
+
+static void
+push_buffer (GstHarness * h, gsize size, guint64 offset)
+{
+  GstBuffer *buf = gst_harness_create_buffer (h, size);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+}
+
+static void
+assert_stats_double (const GstStructure * stats, const gchar * field,
+    gdouble expected)
+{
+  gdouble value;
+
+  fail_unless (gst_structure_get_double (stats, field, &value), field);
+  fail_unless (value == expected, "%s: %f != %f", field, value, expected);
+}
+
+GST_START_TEST (test_streams)
+{
+  GstElement *mux;
+  GstHarness *video, *audio;
+  GstStructure *stats;
+  const GstStructure *stream;
+  const GValue *streams;
+  gchar *message;
+  guint i, n_streams;
+
+  mux = gst_element_factory_make ("throughputmux", NULL);
+  fail_unless (mux != NULL);
+  gst_util_set_object_arg (G_OBJECT (mux), "clock-source", "pipeline");
+  g_object_set (mux, "silent", FALSE, NULL);
+
+  video = gst_harness_new_with_element (mux, "sink_0", "src_0");
+  audio = gst_harness_new_with_element (mux, "sink_1", "src_1");
+  gst_object_unref (mux);
+  gst_harness_set_src_caps_str (video, VIDEO_CAPS);
+  gst_harness_set_src_caps_str (audio, AUDIO_CAPS);
+
+  /* the first tick only starts the first interval */
+  push_buffer (video, 1152, 0);
+  push_buffer (audio, 1920, 0);
+  fail_unless (gst_harness_crank_single_clock_wait (audio));
+
+  for (i = 1; i <= 30; i++)
+    push_buffer (video, 1152, i);
+  for (i = 1; i <= 100; i++)
+    push_buffer (audio, 1920, i * 480);
+  fail_unless (gst_harness_crank_single_clock_wait (audio));
+
+  g_object_get (audio->element, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint (stats, "active-streams", &n_streams));
+  fail_unless_equals_int (n_streams, 2);
+  assert_stats_double (stats, "buffers-per-second", 130.0);
+  assert_stats_double (stats, "bytes-per-second", 30.0 * 1152 + 100.0 * 1920);
+  fail_unless_equals_string (gst_structure_get_string (stats,
+          "slowest-stream"), "sink_0");
+
+  streams = gst_structure_get_value (stats, "streams");
+  fail_unless_equals_int (gst_value_array_get_size (streams), 2);
+  stream = gst_value_get_structure (gst_value_array_get_value (streams, 0));
+  fail_unless (gst_structure_has_name (stream, "sink_0"));
+  assert_stats_double (stream, "offsets-per-second", 30.0);
+  stream = gst_value_get_structure (gst_value_array_get_value (streams, 1));
+  fail_unless (gst_structure_has_name (stream, "sink_1"));
+  assert_stats_double (stream, "offsets-per-second", 48000.0);
+  gst_structure_free (stats);
+
+  g_object_get (audio->element, "last-message", &message, NULL);
+  fail_unless_equals_string (message,
+      "Transfering 130 Buffers/s at 1.73 MBit/s in 2 streams, slowest sink_0 at 30 Buffers/s");
+  g_free (message);
+
+  gst_harness_teardown (video);
+  gst_harness_teardown (audio);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_max_streams)
+{
+  GstElement *mux;
+  GstPad *pad;
+
+  mux = gst_element_factory_make ("throughputmux", NULL);
+  g_object_set (mux, "max-streams", 2, NULL);
+
+  pad = gst_element_request_pad_simple (mux, "sink_%u");
+  fail_unless (pad != NULL);
+  gst_object_unref (pad);
+  pad = gst_element_request_pad_simple (mux, "sink_%u");
+  fail_unless (pad != NULL);
+  fail_unless (gst_element_request_pad_simple (mux, "sink_%u") == NULL);
+
+  /* a released stream makes room again, its pads go away with it */
+  gst_element_release_request_pad (mux, pad);
+  gst_object_unref (pad);
+  fail_unless (gst_element_get_static_pad (mux, "src_1") == NULL);
+  pad = gst_element_request_pad_simple (mux, "sink_%u");
+  fail_unless (pad != NULL);
+  fail_unless_equals_string (GST_PAD_NAME (pad), "sink_1");
+  gst_object_unref (pad);
+
+  gst_object_unref (mux);
+}
+
+GST_END_TEST;
+
+static Suite *
+throughputmux_suite (void)
+{
+  Suite *s = suite_create ("throughputmux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_streams);
+  tcase_add_test (tc_chain, test_max_streams);
+
+  return s;
+}
+
+GST_CHECK_MAIN (throughputmux);
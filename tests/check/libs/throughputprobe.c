@@ -0,0 +1,107 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* The probe API measuring the src pad of an element in a GstHarness, with
+ * the reports scheduled on the harness' GstTestClock. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#include "gstthroughputprobe.h"
+
+#define VIDEO_CAPS "video/x-raw,format=I420,width=32,height=24," \
+    "framerate=30000/1001"
+
+static void
+push_buffer (GstHarness * h, gsize size, guint64 offset)
+{
+  GstBuffer *buf = gst_harness_create_buffer (h, size);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+}
+
+GST_START_TEST (test_attach_detach)
+{
+  GstHarness *h;
+  GstTestClock *clock;
+  GstThroughputProbe *probe;
+  GstStructure *stats;
+  GstPad *srcpad;
+  gdouble value;
+  guint i;
+
+  h = gst_harness_new ("throughput");
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS);
+  push_buffer (h, 1152, 0);
+
+  /* attached to a stream that is already running */
+  clock = gst_harness_get_testclock (h);
+  srcpad = gst_element_get_static_pad (h->element, "src");
+  probe = gst_throughput_probe_attach_with_clock (srcpad, 1000,
+      GST_CLOCK (clock));
+  fail_unless (probe != NULL);
+  fail_unless (gst_throughput_probe_get_stats (probe) == NULL);
+
+  /* the first tick only starts the first interval */
+  push_buffer (h, 1152, 1);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  for (i = 2; i <= 31; i++)
+    push_buffer (h, 1152, i);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  stats = gst_throughput_probe_get_stats (probe);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_has_name (stats, "throughput"));
+  fail_unless_equals_string (gst_structure_get_string (stats, "media-kind"),
+      "video");
+  fail_unless (gst_structure_get_double (stats, "buffers-per-second",
+          &value));
+  fail_unless_equals_float (value, 30.0);
+  fail_unless (gst_structure_get_double (stats, "offsets-per-second",
+          &value));
+  fail_unless_equals_float (value, 30.0);
+  gst_structure_free (stats);
+
+  /* the stream keeps flowing without it */
+  gst_throughput_probe_detach (probe);
+  push_buffer (h, 1152, 32);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (clock);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+throughputprobe_suite (void)
+{
+  Suite *s = suite_create ("throughputprobe");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_attach_detach);
+
+  return s;
+}
+
+GST_CHECK_MAIN (throughputprobe);
@@ -0,0 +1,485 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* Finds the bottleneck of a pipeline: puts a throughput element with
+ * backpressure=true into every link between the top-level elements of a
+ * gst-launch description, including the ones made later from sometimes
+ * pads, runs it for a while and ranks the elements by the share of time
+ * their upstream had to wait for them alone.
+ *
+ *   gst-throughput-bottleneck [-t seconds] [-i milliseconds] PIPELINE...
+ *
+ * The time a push into an element blocks covers its own work and that of
+ * everything downstream of it in the same thread, so the "self" share is
+ * what remains of it after subtracting the blocked share of its own
+ * output. Rates are in buffers, so the drop also shows an element that
+ * merges or splits buffers.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <gst/gst.h>
+
+#define DEFAULT_DURATION 10
+#define DEFAULT_INTERVAL 1000
+
+/* one instrumented link, from upstream's src pad to downstream's sink pad */
+typedef struct
+{
+  GstElement *throughput;
+  GstElement *upstream;
+  GstElement *downstream;
+
+  /* sums over all reports, only touched from the main loop */
+  guint64 time;
+  guint64 buffers;
+  guint64 bytes;
+  guint64 blocked_time;
+} Link;
+
+typedef struct
+{
+  GstElement *element;
+  gdouble in_rate;
+  gdouble out_rate;
+  gdouble out_bitrate;
+  gdouble blocked;
+  gdouble out_blocked;
+  gdouble self;
+  gboolean have_input;
+  gboolean have_output;
+} Stage;
+
+typedef struct
+{
+  GstElement *pipeline;
+  guint interval;
+  GMainLoop *loop;
+  gboolean failed;
+
+  /* links can be added by the streaming threads from pad-added */
+  GMutex lock;
+  GPtrArray *links;
+} Bottleneck;
+
+static void
+link_free (Link * link)
+{
+  gst_object_unref (link->throughput);
+  gst_object_unref (link->upstream);
+  gst_object_unref (link->downstream);
+  g_free (link);
+}
+
+static Link *
+find_link (Bottleneck * b, GstObject * throughput)
+{
+  Link *link;
+  guint i;
+
+  for (i = 0; i < b->links->len; i++) {
+    link = g_ptr_array_index (b->links, i);
+    if (GST_OBJECT_CAST (link->throughput) == throughput)
+      return link;
+  }
+
+  return NULL;
+}
+
+/* puts a throughput element between srcpad and its peer, if both belong
+ * to top-level elements of the pipeline */
+static void
+instrument (Bottleneck * b, GstPad * srcpad)
+{
+  GstElement *upstream, *downstream = NULL, *throughput;
+  GstPad *peer, *sinkpad, *tsrcpad;
+  Link *link;
+
+  peer = gst_pad_get_peer (srcpad);
+  if (!peer)
+    return;
+
+  upstream = gst_pad_get_parent_element (srcpad);
+  downstream = gst_pad_get_parent_element (peer);
+  if (!upstream || !downstream ||
+      GST_OBJECT_PARENT (upstream) != GST_OBJECT_CAST (b->pipeline) ||
+      GST_OBJECT_PARENT (downstream) != GST_OBJECT_CAST (b->pipeline))
+    goto out;
+
+  /* one of our own throughput elements, the link is done already */
+  g_mutex_lock (&b->lock);
+  if (find_link (b, GST_OBJECT_CAST (upstream)) ||
+      find_link (b, GST_OBJECT_CAST (downstream))) {
+    g_mutex_unlock (&b->lock);
+    goto out;
+  }
+  g_mutex_unlock (&b->lock);
+
+  throughput = gst_element_factory_make ("throughput", NULL);
+  g_object_set (throughput, "interval", b->interval, "backpressure", TRUE,
+      NULL);
+
+  gst_pad_unlink (srcpad, peer);
+  gst_bin_add (GST_BIN (b->pipeline), throughput);
+  sinkpad = gst_element_get_static_pad (throughput, "sink");
+  tsrcpad = gst_element_get_static_pad (throughput, "src");
+  if (gst_pad_link (srcpad, sinkpad) != GST_PAD_LINK_OK ||
+      gst_pad_link (tsrcpad, peer) != GST_PAD_LINK_OK)
+    g_printerr ("Could not instrument %s:%s\n", GST_DEBUG_PAD_NAME (srcpad));
+  gst_object_unref (sinkpad);
+  gst_object_unref (tsrcpad);
+  gst_element_sync_state_with_parent (throughput);
+
+  link = g_new0 (Link, 1);
+  link->throughput = gst_object_ref (throughput);
+  link->upstream = gst_object_ref (upstream);
+  link->downstream = gst_object_ref (downstream);
+  g_mutex_lock (&b->lock);
+  g_ptr_array_add (b->links, link);
+  g_mutex_unlock (&b->lock);
+
+out:
+  if (upstream)
+    gst_object_unref (upstream);
+  if (downstream)
+    gst_object_unref (downstream);
+  gst_object_unref (peer);
+}
+
+/* runs after the delayed linking of gst_parse_launch, which was connected
+ * first, so the new pad is already linked */
+static void
+pad_added (GstElement * element, GstPad * pad, Bottleneck * b)
+{
+  if (GST_PAD_IS_SRC (pad))
+    instrument (b, pad);
+}
+
+static void
+instrument_element (GstElement * element, Bottleneck * b)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GList *pads = NULL, *l;
+
+  g_signal_connect (element, "pad-added", G_CALLBACK (pad_added), b);
+
+  /* collected first, instrument changes the pads of the element */
+  it = gst_element_iterate_src_pads (element);
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    pads = g_list_prepend (pads, g_value_dup_object (&item));
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  for (l = pads; l; l = l->next)
+    instrument (b, l->data);
+  g_list_free_full (pads, gst_object_unref);
+}
+
+static void
+instrument_pipeline (Bottleneck * b)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GList *elements = NULL, *l;
+
+  /* the throughput elements added on the way are not instrumented */
+  it = gst_bin_iterate_elements (GST_BIN (b->pipeline));
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    elements = g_list_prepend (elements, g_value_dup_object (&item));
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  for (l = elements; l; l = l->next)
+    instrument_element (l->data, b);
+  g_list_free_full (elements, gst_object_unref);
+}
+
+static void
+add_report (Bottleneck * b, GstObject * src, const GstStructure * s)
+{
+  guint64 interval = 0, buffers = 0, bytes = 0, blocked = 0;
+  Link *link;
+
+  g_mutex_lock (&b->lock);
+  link = find_link (b, src);
+  if (link && gst_structure_get (s,
+          "interval", G_TYPE_UINT64, &interval,
+          "interval-buffers", G_TYPE_UINT64, &buffers,
+          "interval-bytes", G_TYPE_UINT64, &bytes,
+          "blocked-time", G_TYPE_UINT64, &blocked, NULL)) {
+    link->time += interval;
+    link->buffers += buffers;
+    link->bytes += bytes;
+    link->blocked_time += blocked;
+  }
+  g_mutex_unlock (&b->lock);
+}
+
+static gboolean
+bus_message (GstBus * bus, GstMessage * message, Bottleneck * b)
+{
+  const GstStructure *s;
+  GError *error = NULL;
+  gchar *debug = NULL;
+
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_ELEMENT:
+      s = gst_message_get_structure (message);
+      if (gst_structure_has_name (s, "throughput"))
+        add_report (b, GST_MESSAGE_SRC (message), s);
+      break;
+    case GST_MESSAGE_ERROR:
+      gst_message_parse_error (message, &error, &debug);
+      g_printerr ("Error from %s: %s\n%s\n", GST_MESSAGE_SRC_NAME (message),
+          error->message, debug ? debug : "");
+      g_clear_error (&error);
+      g_free (debug);
+      b->failed = TRUE;
+      g_main_loop_quit (b->loop);
+      break;
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (b->loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+timeout (Bottleneck * b)
+{
+  g_main_loop_quit (b->loop);
+
+  return FALSE;
+}
+
+static gint
+compare_stages (gconstpointer a, gconstpointer b)
+{
+  const Stage *sa = a, *sb = b;
+
+  /* sources have no input to wait for them and go last */
+  if (sa->have_input != sb->have_input)
+    return sa->have_input ? -1 : 1;
+  if (sa->self != sb->self)
+    return sa->self > sb->self ? -1 : 1;
+
+  return 0;
+}
+
+static Stage *
+find_stage (GArray * stages, GstElement * element)
+{
+  Stage stage = { 0, };
+  guint i;
+
+  for (i = 0; i < stages->len; i++)
+    if (g_array_index (stages, Stage, i).element == element)
+      return &g_array_index (stages, Stage, i);
+
+  stage.element = element;
+  g_array_append_val (stages, stage);
+
+  return &g_array_index (stages, Stage, stages->len - 1);
+}
+
+static void
+print_table (Bottleneck * b)
+{
+  GArray *stages = g_array_new (FALSE, TRUE, sizeof (Stage));
+  gdouble rate, blocked, drop;
+  Stage *stage;
+  Link *link;
+  guint i;
+
+  for (i = 0; i < b->links->len; i++) {
+    link = g_ptr_array_index (b->links, i);
+    if (link->time == 0)
+      continue;
+
+    rate = (gdouble) link->buffers * GST_SECOND / link->time;
+    blocked = (gdouble) link->blocked_time / link->time;
+
+    /* a mixer is as slow as its slowest input, a tee as its slowest
+     * branch */
+    stage = find_stage (stages, link->upstream);
+    stage->have_output = TRUE;
+    stage->out_rate += rate;
+    stage->out_bitrate += (gdouble) link->bytes * 8 * GST_SECOND / link->time;
+    stage->out_blocked = MAX (stage->out_blocked, blocked);
+
+    stage = find_stage (stages, link->downstream);
+    stage->have_input = TRUE;
+    stage->in_rate += rate;
+    stage->blocked = MAX (stage->blocked, blocked);
+  }
+
+  /* what upstream waited for minus what the element waited for itself */
+  for (i = 0; i < stages->len; i++) {
+    stage = &g_array_index (stages, Stage, i);
+    stage->self = MAX (stage->blocked - stage->out_blocked, 0.0);
+  }
+  g_array_sort (stages, compare_stages);
+
+  printf ("%4s  %-32s  %10s  %10s  %10s  %7s  %8s  %6s\n",
+      "RANK", "ELEMENT", "IN BUF/S", "OUT BUF/S", "OUT MBIT/S", "DROP",
+      "BLOCKED", "SELF");
+
+  for (i = 0; i < stages->len; i++) {
+    stage = &g_array_index (stages, Stage, i);
+
+    printf ("%4u  %-32.32s", i + 1, GST_ELEMENT_NAME (stage->element));
+    if (stage->have_input)
+      printf ("  %10.1f", stage->in_rate);
+    else
+      printf ("  %10s", "-");
+    if (stage->have_output)
+      printf ("  %10.1f  %10.2f", stage->out_rate,
+          stage->out_bitrate / 1000000);
+    else
+      printf ("  %10s  %10s", "-", "-");
+    if (stage->have_input && stage->have_output && stage->in_rate > 0) {
+      drop = 1.0 - stage->out_rate / stage->in_rate;
+      printf ("  %6.1f%%", drop * 100);
+    } else {
+      printf ("  %7s", "-");
+    }
+    if (stage->have_input)
+      printf ("  %7.1f%%  %5.1f%%\n", stage->blocked * 100, stage->self * 100);
+    else
+      printf ("  %8s  %6s\n", "-", "-");
+  }
+
+  g_array_free (stages, TRUE);
+}
+
+static void
+usage (const char *name)
+{
+  fprintf (stderr, "Usage: %s [-t seconds] [-i milliseconds] PIPELINE...\n"
+      "  -t seconds       how long to run the pipeline (default %u)\n"
+      "  -i milliseconds  measurement interval (default %u)\n",
+      name, DEFAULT_DURATION, DEFAULT_INTERVAL);
+}
+
+int
+main (int argc, char *argv[])
+{
+  Bottleneck b = { 0, };
+  guint duration = DEFAULT_DURATION;
+  GstElementFactory *factory;
+  GstBus *bus;
+  GError *error = NULL;
+  int opt;
+
+  gst_init (NULL, NULL);
+
+  b.interval = DEFAULT_INTERVAL;
+
+  /* stop at the pipeline description */
+  while ((opt = getopt (argc, argv, "+t:i:h")) != -1) {
+    switch (opt) {
+      case 't':
+        duration = strtoul (optarg, NULL, 10);
+        if (duration == 0)
+          duration = 1;
+        break;
+      case 'i':
+        b.interval = strtoul (optarg, NULL, 10);
+        if (b.interval == 0)
+          b.interval = DEFAULT_INTERVAL;
+        break;
+      default:
+        usage (argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (optind >= argc) {
+    usage (argv[0]);
+    return 1;
+  }
+
+  factory = gst_element_factory_find ("throughput");
+  if (!factory) {
+    g_printerr ("The throughput element was not found, "
+        "set GST_PLUGIN_PATH to the directory of libgsttiming\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  b.pipeline = gst_parse_launchv ((const gchar **) argv + optind, &error);
+  if (!b.pipeline) {
+    g_printerr ("Could not build the pipeline: %s\n", error->message);
+    g_clear_error (&error);
+    return 1;
+  }
+  if (error) {
+    g_printerr ("Warning: %s\n", error->message);
+    g_clear_error (&error);
+  }
+  if (!GST_IS_PIPELINE (b.pipeline)) {
+    g_printerr ("The description has to make a pipeline of several "
+        "elements\n");
+    gst_object_unref (b.pipeline);
+    return 1;
+  }
+
+  g_mutex_init (&b.lock);
+  b.links = g_ptr_array_new_with_free_func ((GDestroyNotify) link_free);
+  b.loop = g_main_loop_new (NULL, FALSE);
+
+  instrument_pipeline (&b);
+
+  bus = gst_element_get_bus (b.pipeline);
+  gst_bus_add_watch (bus, (GstBusFunc) bus_message, &b);
+
+  g_print ("Measuring %u links for %u seconds...\n", b.links->len,
+      duration);
+  g_timeout_add_seconds (duration, (GSourceFunc) timeout, &b);
+  if (gst_element_set_state (b.pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    g_printerr ("Could not start the pipeline\n");
+    b.failed = TRUE;
+  } else {
+    g_main_loop_run (b.loop);
+  }
+
+  gst_element_set_state (b.pipeline, GST_STATE_NULL);
+  gst_bus_remove_watch (bus);
+  gst_object_unref (bus);
+
+  print_table (&b);
+
+  g_ptr_array_unref (b.links);
+  g_main_loop_unref (b.loop);
+  gst_object_unref (b.pipeline);
+  g_mutex_clear (&b.lock);
+
+  return b.failed ? 1 : 0;
+}
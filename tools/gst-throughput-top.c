@@ -0,0 +1,199 @@
+/* gst-plugin-timing
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *                     Version 2, December 2004
+ *
+ *  Copyright (C) 2004 Sam Hocevar
+ *   14 rue de Plaisance, 75014 Paris, France
+ *  Everyone is permitted to copy and distribute verbatim or modified
+ *  copies of this license document, and changing it is allowed as long
+ *  as the name is changed.
+ *
+ *             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+ *    TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+ *
+ *   0. You just DO WHAT THE FUCK YOU WANT TO.
+ */
+
+/* Shows the stats every throughput element with a shm-dir publishes, for
+ * all processes on the host, refreshed like top.
+ *
+ *   gst-throughput-top [-d dir] [-i seconds] [-n]
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gstthroughputshm.h"
+
+#define DEFAULT_DIR "/dev/shm/gst-throughput"
+
+static const char *media_kinds[] = { "other", "video", "audio" };
+
+static uint64_t
+monotonic_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int
+process_alive (uint32_t pid)
+{
+  return kill ((pid_t) pid, 0) == 0 || errno != ESRCH;
+}
+
+static void
+show_file (const char *path, uint64_t now)
+{
+  const GstThroughputShm *shm;
+  GstThroughputShm stats;
+  const char *kind, *state;
+  double age, percent;
+  struct stat st;
+  int fd;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return;
+  if (fstat (fd, &st) < 0 || st.st_size < (off_t) sizeof (GstThroughputShm)) {
+    close (fd);
+    return;
+  }
+  shm = mmap (NULL, sizeof (GstThroughputShm), PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (shm == MAP_FAILED)
+    return;
+
+  if (shm->magic != GST_THROUGHPUT_SHM_MAGIC ||
+      shm->version != GST_THROUGHPUT_SHM_VERSION) {
+    munmap ((void *) shm, sizeof (GstThroughputShm));
+    return;
+  }
+
+  if (!gst_throughput_shm_read (shm, &stats)) {
+    /* copied before unmapping, possibly torn by the writer */
+    stats.pid = shm->pid;
+    memcpy (stats.name, shm->name, sizeof (stats.name));
+    stats.name[sizeof (stats.name) - 1] = '\0';
+    munmap ((void *) shm, sizeof (GstThroughputShm));
+    printf ("%7u  %-40.40s  (busy)\n", stats.pid, stats.name);
+    return;
+  }
+  munmap ((void *) shm, sizeof (GstThroughputShm));
+
+  kind = stats.media_kind < 3 ? media_kinds[stats.media_kind] : "?";
+  if (!process_alive (stats.pid))
+    state = "dead";
+  else if (stats.timestamp == 0)
+    state = "idle";
+  else
+    state = "";
+
+  age = stats.timestamp && now > stats.timestamp ?
+      (double) (now - stats.timestamp) / 1e9 : 0.0;
+  percent = stats.nominal_rate > 0 ?
+      stats.offsets_per_second / stats.nominal_rate * 100 : 0.0;
+
+  printf ("%7u  %-40.40s  %-5s  %9.0f  %10.2f  %10.0f  %6.1f  %6.1f  %s\n",
+      stats.pid, stats.name, kind, stats.buffers_per_second,
+      stats.bytes_per_second * 8 / 1024 / 1024, stats.offsets_per_second,
+      percent, age, state);
+}
+
+static int
+show (const char *dir)
+{
+  struct dirent *entry;
+  size_t len, suffix_len = strlen (GST_THROUGHPUT_SHM_SUFFIX);
+  uint64_t now = monotonic_now ();
+  char path[4096];
+  DIR *d;
+
+  d = opendir (dir);
+  if (!d) {
+    fprintf (stderr, "Could not open %s: %s\n", dir, strerror (errno));
+    return 0;
+  }
+
+  printf ("%7s  %-40s  %-5s  %9s  %10s  %10s  %6s  %6s\n",
+      "PID", "ELEMENT", "KIND", "BUFFERS/S", "MBIT/S", "UNITS/S", "%RATE",
+      "AGE/S");
+
+  while ((entry = readdir (d))) {
+    len = strlen (entry->d_name);
+    if (len <= suffix_len ||
+        strcmp (entry->d_name + len - suffix_len, GST_THROUGHPUT_SHM_SUFFIX))
+      continue;
+
+    snprintf (path, sizeof (path), "%s/%s", dir, entry->d_name);
+    show_file (path, now);
+  }
+  closedir (d);
+
+  return 1;
+}
+
+static void
+usage (const char *name)
+{
+  fprintf (stderr, "Usage: %s [-d dir] [-i seconds] [-n]\n"
+      "  -d dir      directory the elements publish to (default %s)\n"
+      "  -i seconds  refresh interval (default 1)\n"
+      "  -n          print once and exit\n", name, DEFAULT_DIR);
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *dir = DEFAULT_DIR;
+  unsigned int interval = 1;
+  int once = 0, opt;
+
+  while ((opt = getopt (argc, argv, "d:i:nh")) != -1) {
+    switch (opt) {
+      case 'd':
+        dir = optarg;
+        break;
+      case 'i':
+        interval = strtoul (optarg, NULL, 10);
+        if (interval == 0)
+          interval = 1;
+        break;
+      case 'n':
+        once = 1;
+        break;
+      default:
+        usage (argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (once)
+    return show (dir) ? 0 : 1;
+
+  for (;;) {
+    /* clear the screen and move to the top left */
+    printf ("\033[H\033[2J");
+    if (!show (dir))
+      return 1;
+    fflush (stdout);
+    sleep (interval);
+  }
+
+  return 0;
+}
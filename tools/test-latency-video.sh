@@ -0,0 +1,8 @@
+#!/bin/sh
+GST_PLUGIN_PATH=`dirname $0`/../src/ gst-launch-1.0 \
+	videotestsrc ! \
+	video/x-raw,width=1920,height=1080,framerate=25/1,format=I420 ! \
+	latencystamp ! \
+	x264enc ! \
+	latencyprobe stderr=true interval=500 name=x264 ! \
+	fakesink silent=TRUE